@@ -0,0 +1,98 @@
+#ifndef __CONTROLTIMER_H__
+#define __CONTROLTIMER_H__
+#include <Arduino.h>
+
+// Timer1 runs in CTC mode with a prescaler of 64, so at 16 MHz each count is 4 microseconds and the longest
+// period the 16-bit compare register allows is 65536 counts.
+#define CONTROL_TIMER_PRESCALER 64
+#define CONTROL_TIMER_MICROS_PER_COUNT (CONTROL_TIMER_PRESCALER/(F_CPU/1000000UL))
+#define CONTROL_TIMER_MAX_PERIOD_MICROS (65536UL*CONTROL_TIMER_MICROS_PER_COUNT)
+
+/// @brief The state latched by the timer interrupt at a control tick.
+typedef struct {
+    uint32_t count;                 // the number of the tick since the timer was started, starting at 1
+    uint32_t micros;                // when the tick's interrupt ran
+    uint32_t left_wheel_counter;
+    uint32_t right_wheel_counter;
+} ControlTick;
+
+/// @brief A fixed rate control tick driven by the Timer1 compare interrupt. The interrupt only latches the tick's
+/// timestamp and lets a sampler function latch sensor values that are safe to read with interrupts disabled, such
+/// as the wheel counters. The foreground picks the tick up with `take_tick()` and runs the control update, which
+/// is where sensors that need interrupts (such as the I2C gyro) are read and where logging is done. Because the
+/// period comes from the hardware timer, it does not drift with the time the foreground takes.
+///
+/// The timer records how far each interrupt's interval was from the period (jitter, which comes from interrupts
+/// being disabled elsewhere), how late the foreground picked up each tick (latency), and how many ticks the
+/// foreground missed entirely because it was busy for longer than a period (overruns).
+class ControlTimer {
+public:
+    /// @brief Latches sensor values into a tick. Called from the timer interrupt, so it must be quick.
+    typedef void (*Sampler)(ControlTick& tick);
+
+private:
+    Sampler _sampler;
+    uint32_t _periodMicros;
+    bool _running;
+
+    // written by the interrupt. The foreground only reads these inside ATOMIC_BLOCKs.
+    ControlTick _latest;
+    volatile uint32_t _maxJitterMicros;
+
+    uint32_t _lastTakenCount;
+    uint32_t _overruns;
+    uint32_t _maxLatencyMicros;
+
+public:
+    static ControlTimer* instance;
+
+    ControlTimer();
+    virtual ~ControlTimer();
+
+    /// @brief Called by the Timer1 compare interrupt.
+    void handleISR();
+
+    /// @brief Starts the ticks and resets the statistics, see `reset()`.
+    void start(uint32_t period_micros, Sampler sampler = nullptr);
+
+    /// @brief Sets the period and the sampler, and resets the ticks and the statistics, without starting the hardware
+    /// timer. `start()` does this first. The tests call this and simulate the interrupts with `handleISR()`, so the
+    /// real interrupt does not tick at the same time. Must not be called while the timer is running.
+    /// @param period_micros The tick period in microseconds. Rounded to a multiple of `CONTROL_TIMER_MICROS_PER_COUNT`
+    /// and limited to `CONTROL_TIMER_MAX_PERIOD_MICROS`.
+    /// @param sampler The function that latches the sensor values at each tick, or nullptr.
+    void reset(uint32_t period_micros, Sampler sampler = nullptr);
+
+    /// @brief Stops the ticks.
+    void stop();
+
+    bool is_running() const                             { return _running; }
+    uint32_t period_micros() const                      { return _periodMicros; }
+
+    /// @brief Takes the latest tick if there has been one since the last call.
+    /// @param tick Set to the latest tick.
+    /// @return true if there was a new tick, false otherwise.
+    bool take_tick(ControlTick& tick);
+
+    /// @brief Provides the time of a tick in milliseconds since the timer was started, from the tick count. Unlike
+    /// `millis()` this advances by exactly one period per tick, which gives controllers a steady time step.
+    uint32_t tick_millis(const ControlTick& tick) const { return (tick.count*_periodMicros)/1000; }
+
+    /// @brief Provides the time left before the tick after the given one is due, so the foreground can tell whether it
+    /// has time for slow work once it has processed a tick.
+    uint32_t micros_to_next_tick(const ControlTick& tick) const;
+
+    /// @brief Provides the number of ticks the foreground missed because it took longer than a period.
+    uint32_t overruns() const                           { return _overruns; }
+
+    /// @brief Provides the largest difference between the interval of two consecutive ticks and the period.
+    uint32_t max_jitter_micros() const;
+
+    /// @brief Provides the longest time between a tick and the foreground taking it.
+    uint32_t max_latency_micros() const                 { return _maxLatencyMicros; }
+
+    /// @brief Logs the tick statistics at the DEBUG level.
+    void log_statistics();
+};
+
+#endif // __CONTROLTIMER_H__
@@ -1,12 +1,88 @@
 #ifndef __DATALOGGER_H__
 #define __DATALOGGER_H__
 #include <Arduino.h>
+#include <SD.h>
 #include "DataTable.h"
+#include "LogEvent.h"
+#include "RingBuffer.h"
 
+// The lowest log level that is compiled into the firmware, set with the MIN_LOG_LEVEL build flag in platformio.ini.
+// The levels are 0 = DEBUG, 1 = INFO, 2 = WARNING, 3 = ERROR and 4 = no logging. Log macros below this level, including
+// the formatting of their arguments, compile to nothing. The runtime log level of the DataLogger still applies to the
+// levels that are compiled in.
+#ifndef MIN_LOG_LEVEL
+#define MIN_LOG_LEVEL 0
+#endif
+
+// The *_LOGF macros take a printf style format string literal (which is placed in flash) and its arguments. The
+// arguments are only evaluated and formatted if the level is currently enabled.
+#define LOG_FORMATTED(level, format, ...) do { \
+        if (DataLogger::getInstance()->is_enabled(level)) { \
+            snprintf_P(DataLogger::commonBuffer(), LOG_COMMON_BUFFER_SIZE, PSTR(format), ##__VA_ARGS__); \
+            DataLogger::getInstance()->log(level, DataLogger::commonBuffer()); \
+        } \
+    } while (0)
+#define LOG_DISABLED do { } while (0)
+
+// The *_EVENT macros log a structured event: only the `LogEventID`, a timestamp and the binary arguments are written.
+// The format string literal is not compiled into the firmware. `tools/log_events.py` builds the event dictionary from
+// it and uses that to decode the logs back into text.
+#define LOG_EVENT(level, event_id, ...) do { \
+        if (DataLogger::getInstance()->is_enabled(level)) { \
+            DataLogger::getInstance()->log_event(level, event_id, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if MIN_LOG_LEVEL <= 0
 #define DEBUG_LOG(message) DataLogger::getInstance()->debug(message)
+#define DEBUG_LOGF(format, ...) LOG_FORMATTED(DataLogger::DEBUG, format, ##__VA_ARGS__)
+#define DEBUG_EVENT(event_id, format, ...) LOG_EVENT(DataLogger::DEBUG, event_id, ##__VA_ARGS__)
+#else
+#define DEBUG_LOG(message) LOG_DISABLED
+#define DEBUG_LOGF(format, ...) LOG_DISABLED
+#define DEBUG_EVENT(event_id, format, ...) LOG_DISABLED
+#endif
+
+#if MIN_LOG_LEVEL <= 1
 #define INFO_LOG(message) DataLogger::getInstance()->info(message)
+#define INFO_LOGF(format, ...) LOG_FORMATTED(DataLogger::INFO, format, ##__VA_ARGS__)
+#define INFO_EVENT(event_id, format, ...) LOG_EVENT(DataLogger::INFO, event_id, ##__VA_ARGS__)
+#else
+#define INFO_LOG(message) LOG_DISABLED
+#define INFO_LOGF(format, ...) LOG_DISABLED
+#define INFO_EVENT(event_id, format, ...) LOG_DISABLED
+#endif
+
+#if MIN_LOG_LEVEL <= 2
 #define WARNING_LOG(message) DataLogger::getInstance()->warning(message)
+#define WARNING_LOGF(format, ...) LOG_FORMATTED(DataLogger::WARNING, format, ##__VA_ARGS__)
+#define WARNING_EVENT(event_id, format, ...) LOG_EVENT(DataLogger::WARNING, event_id, ##__VA_ARGS__)
+#else
+#define WARNING_LOG(message) LOG_DISABLED
+#define WARNING_LOGF(format, ...) LOG_DISABLED
+#define WARNING_EVENT(event_id, format, ...) LOG_DISABLED
+#endif
+
+#if MIN_LOG_LEVEL <= 3
 #define ERROR_LOG(message) DataLogger::getInstance()->error(message)
+#define ERROR_LOGF(format, ...) LOG_FORMATTED(DataLogger::ERROR, format, ##__VA_ARGS__)
+#define ERROR_EVENT(event_id, format, ...) LOG_EVENT(DataLogger::ERROR, event_id, ##__VA_ARGS__)
+#else
+#define ERROR_LOG(message) LOG_DISABLED
+#define ERROR_LOGF(format, ...) LOG_DISABLED
+#define ERROR_EVENT(event_id, format, ...) LOG_DISABLED
+#endif
+
+#define LOG_COMMON_BUFFER_SIZE 256
+
+// size of the RAM buffer that log messages are queued in for the SD card when the logger is in buffered mode
+#define LOG_BUFFER_SIZE 1024
+// size of the RAM buffer that log messages are queued in for Serial when the logger is in buffered mode
+#define LOG_SERIAL_BUFFER_SIZE 384
+// buffered log data is written to the SD card in chunks of this size, which is the SD card sector size
+#define LOG_SECTOR_SIZE 512
+// the maximum number of queued bytes that are sent to Serial per call to `DataLogger::loop()`
+#define LOG_SERIAL_DRAIN_BYTES 64
 
 class DataLogger {
 public:
@@ -18,32 +94,109 @@ public:
         ERROR = 3
     } LogType;
 
+    typedef enum {
+        CSV_TABLE = 0,
+        BINARY_TABLE = 1,
+        COMPRESSED_TABLE = 2
+    } TableFormat;
+
 private:
-    char _buffer[256];
-    char _commonBuffer[256];
+    char _commonBuffer[LOG_COMMON_BUFFER_SIZE];
 
     int _logSequenceNumber;
     char _logFileName[20];
     LogType _logLevel;
 
+    bool _buffered;
+    File _logFile;
+    RingBuffer<LOG_BUFFER_SIZE> _logBuffer;
+    RingBuffer<LOG_SERIAL_BUFFER_SIZE> _serialBuffer;
+    unsigned long _lastSyncMillis;
+    bool _logFileDirty;             // data was written to the log file since it was last flushed
+    unsigned long _maxWriteMicros;
+    uint32_t _droppedRecords;
+    uint32_t _droppedBytes;
+
+    TableFormat _tableFormat;
+    int _tableSequenceNumber;
+
+    template <typename M> void write_log_message(LogType logType, const M& message);
+    template <typename B, typename M> void enqueue_log_record(B& buffer, const String& prefix, const M& message, uint16_t length);
+    template <typename B> void enqueue_log_bytes(B& buffer, const uint8_t* data, uint16_t length);
+    void write_event_record(const LogEventRecord& record);
+    template <typename T> void write_binary_table(const DataTable<T>& dataTable, const DataColumnFormat* formats);
+    template <typename T> void log_table_usage(const DataTable<T>& dataTable);
+    template <typename T, typename F> void write_table(const DataTable<T>& dataTable, F format);
+    void write_log_buffer(uint16_t max_bytes);
+    void write_serial_buffer(uint16_t max_bytes);
+    void flush_log_file();
 
 protected:
     static DataLogger* _instance;
 
     const String& get_log_prefix(LogType logType) const;
 public:
-    static void init(LogType log_level = DEBUG)         { new DataLogger(log_level); }
+    /// @brief Creates the logger singleton.
+    /// @param log_level The minimum level of messages that will be logged.
+    /// @param buffered If true, log calls only queue the message in RAM and `loop()` writes a bounded amount of the
+    /// queued data to Serial and the SD card (a sector at a time, with the log file kept open) per call, so logging
+    /// never blocks. If false, every message is written immediately and the log file is opened and closed for each.
+    static void init(LogType log_level = DEBUG, bool buffered = true)  { new DataLogger(log_level, buffered); }
     static DataLogger* getInstance()                    { return _instance; }
 
     static char* commonBuffer()                         { return _instance->_commonBuffer; }
 
-    DataLogger(LogType log_level);
+    DataLogger(LogType log_level, bool buffered = true);
     virtual ~DataLogger();
 
-    void loop();
+    /// @brief Sends as much queued log data to Serial as it can take without blocking (up to `LOG_SERIAL_DRAIN_BYTES`),
+    /// and writes at most one sector of queued log data to the SD card. Should be called regularly. `Robot::loop()`
+    /// calls this.
+    /// @param idle Whether time critical work is paused, such as while the robot is not in motion. Only then is a
+    /// partial sector written and the log file flushed, at most every `LOG_SYNC_INTERVAL_MILLIS`, as the flush also
+    /// writes the file's directory entry.
+    void loop(bool idle = true);
+
+    /// @brief Writes all queued log data to Serial and the SD card and flushes the log file. This blocks until done.
+    void sync();
+
+    /// @brief Provides the number of log records that were dropped because a log queue was full.
+    uint32_t dropped_records() const                    { return _droppedRecords; }
+
+    /// @brief Provides the number of log bytes that were dropped because a log queue was full.
+    uint32_t dropped_bytes() const                      { return _droppedBytes; }
+
+    /// @brief Provides the longest time a single write of buffered data to the SD card took.
+    /// @return The worst-case write latency in microseconds.
+    unsigned long max_write_micros() const              { return _maxWriteMicros; }
+
+    /// @brief Logs the queue statistics (dropped records and bytes, worst-case write latency) at the INFO level.
+    void log_statistics();
+
+    /// @brief Sets the format that `log_data_table()` writes tables in. CSV tables are written to Serial and the log
+    /// file. Binary tables are written to their own file on the SD card (or to Serial if there is no SD card), and
+    /// can be converted back to CSV with `tools/dtb_to_csv.py`. Compressed tables are binary tables with delta and
+    /// varint coded rows, which usually take a fraction of the space on the SD card. Tables logged with column formats
+    /// have their real values quantized to the formats' decimals when compressed. The default is CSV.
+    void set_table_format(TableFormat format)           { _tableFormat = format; }
+
+    /// @brief Determines whether messages of a log level are currently logged.
+    bool is_enabled(LogType logType) const              { return logType >= _logLevel || logType == NONE; }
+
     void log(LogType, const char* message);
     void log(LogType, const __FlashStringHelper* message);
     void log(LogType logType, const String& message);
+
+    /// @brief Logs a structured event. Use the `*_EVENT` macros rather than calling this directly.
+    /// @param logType The log level of the event.
+    /// @param event_id The `LogEventID` of the event.
+    /// @param args The arguments of the event, which are logged in binary.
+    template <typename... Args> void log_event(LogType logType, uint16_t event_id, Args... args) {
+        if (logType < _logLevel && logType != NONE) {
+            return;
+        }
+        write_event_record(LogEventRecord(logType, event_id, millis(), args...));
+    }
     void log_data_table(const DataTable<double>& dataTable, DataTable<double>::FieldFormatter formatter = [](double value, int col_num) -> String {
         return String(value);
     });
@@ -51,6 +204,11 @@ public:
         return String(value);
     });
 
+    /// @brief Logs a data table, writing CSV values with a `DataColumnFormat` for each column rather than a
+    /// `FieldFormatter`. This formats the values without allocating a `String` for each one, so it is much faster.
+    void log_data_table(const DataTable<double>& dataTable, const DataColumnFormat* formats);
+    void log_data_table(const DataTable<int>& dataTable, const DataColumnFormat* formats);
+
     void debug(const char* message)                     { log(DEBUG, message); }
     void info(const char* message)                      { log(INFO, message); }
     void warning(const char* message)                   { log(WARNING, message); }
@@ -2,46 +2,347 @@
 #define __DATATABLE_H__
 #include <Arduino.h>
 
+/// @brief The storage types a table column can have. The values of this enumeration are used as the column type codes
+/// in the binary table format, so existing values must not be changed.
+typedef enum {
+    DATA_COLUMN_UINT8 = 1,
+    DATA_COLUMN_INT8 = 2,
+    DATA_COLUMN_UINT16 = 3,
+    DATA_COLUMN_INT16 = 4,
+    DATA_COLUMN_UINT32 = 5,
+    DATA_COLUMN_INT32 = 6,
+    DATA_COLUMN_FLOAT32 = 7,
+    DATA_COLUMN_FLOAT64 = 8
+} DataColumnType;
+
+/// @brief Determines the column type code for a C++ type. Uses the size of the type rather than its name, so that
+/// `double` and `int` get the correct code on both AVR (4 and 2 bytes) and larger platforms.
+template <typename T> constexpr DataColumnType data_column_type() {
+    return (T(0.5) != T(0))
+        ? (sizeof(T) == 4 ? DATA_COLUMN_FLOAT32 : DATA_COLUMN_FLOAT64)
+        : (T(-1) < T(0))
+            ? (sizeof(T) == 1 ? DATA_COLUMN_INT8 : (sizeof(T) == 2 ? DATA_COLUMN_INT16 : DATA_COLUMN_INT32))
+            : (sizeof(T) == 1 ? DATA_COLUMN_UINT8 : (sizeof(T) == 2 ? DATA_COLUMN_UINT16 : DATA_COLUMN_UINT32));
+}
+
+/// @brief Provides the number of bytes a value of a column type takes.
+inline uint8_t data_column_size(uint8_t type) {
+    switch (type) {
+        case DATA_COLUMN_UINT8:
+        case DATA_COLUMN_INT8:
+            return 1;
+        case DATA_COLUMN_UINT16:
+        case DATA_COLUMN_INT16:
+            return 2;
+        case DATA_COLUMN_FLOAT64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+// The binary table format is:
+//
+//      "DTB" + format version (1 byte)
+//      flags (1 byte, see below)
+//      number of columns (1 byte)
+//      number of rows (4 bytes)
+//      for each column: type code (1 byte), name length (1 byte), name
+//      the rows, each as the packed column values
+//
+// All multi-byte values are little endian. The `tools/dtb_to_csv.py` script converts this format back to CSV.
+//
+// With the `DATA_TABLE_FLAG_DELTA_VARINT` flag each value is instead written as the difference from the value in the
+// same column of the previous row (the first row is relative to 0), as a LEB128 varint of 7 bits per byte, least
+// significant group first:
+//
+//      integer columns: the difference of the values as 32-bit integers (signed columns sign extended), wrapping
+//          modulo 2^32, then zig-zag encoded so that small negative differences are small too
+//      FLOAT32 columns: the XOR of the bit patterns of the values, which is small when the sign, exponent and high
+//          mantissa bits repeat
+//      FLOAT64 columns: the value unchanged, 8 bytes
+//
+// With the `DATA_TABLE_FLAG_QUANTIZED` flag as well, each column in the header is followed by the number of decimals
+// (1 byte) its values are quantized to, or `DATA_TABLE_NOT_QUANTIZED` for the integer columns. The real valued columns
+// are then coded like the signed integer columns, with each value as the 32-bit integer `round(value*10^decimals)`.
+// Values that are not finite or do not fit are written as `DATA_TABLE_QUANTIZED_INVALID`, and decode as nan. The
+// decimals are those of the column's CSV format, so nothing is lost that the CSV would show. The XOR of two nearby
+// floats still holds the mantissa bits below the difference, and usually takes 4 or 5 bytes.
+//
+// Telemetry changes little from row to row, so most values take 1 or 2 bytes.
+#define DATA_TABLE_BINARY_MAGIC "DTB"
+#define DATA_TABLE_BINARY_VERSION 1
+#define DATA_TABLE_FLAG_DELTA_VARINT 0x01
+#define DATA_TABLE_FLAG_QUANTIZED 0x02
+#define DATA_TABLE_NOT_QUANTIZED 0xFF
+#define DATA_TABLE_QUANTIZED_INVALID INT32_MIN
+#define DATA_TABLE_VARINT_MAX_SIZE 5
+
+/// @brief How `DataTable::write_to_stream()` writes the values of a column as CSV.
+typedef struct {
+    /// Digits after the decimal point, at most `DATA_FORMAT_MAX_DECIMALS`. 0 writes the value rounded to an integer.
+    uint8_t decimals;
+    /// Write values that are exactly zero as "0" rather than with decimals.
+    bool zero_as_integer;
+} DataColumnFormat;
+
+#define DATA_FORMAT_MAX_DECIMALS 8
+#define DATA_FORMAT_BUFFER_SIZE 24
+
+/// @brief Formats numbers for CSV output without allocating. Each function writes a null terminated string into a
+/// buffer of at least `DATA_FORMAT_BUFFER_SIZE` chars and returns its length. `format_data_fixed()` rounds the same
+/// way `Print::print(double, digits)` does, and writes "nan", "inf" or "ovf" for values it can not format.
+uint8_t format_data_integer(char* buffer, int32_t value);
+uint8_t format_data_unsigned(char* buffer, uint32_t value);
+uint8_t format_data_fixed(char* buffer, double value, uint8_t decimals);
+
+/// @brief Encodes a value as a LEB128 varint into a buffer of at least `DATA_TABLE_VARINT_MAX_SIZE` bytes.
+/// @returns The number of bytes used.
+uint8_t encode_varint(uint8_t* buffer, uint32_t value);
+
+/// @brief Quantizes a real value to an integer number of `10^-decimals`, see `DATA_TABLE_FLAG_QUANTIZED`.
+int32_t quantize_data_value(double value, uint8_t decimals);
+
+/// @brief Zig-zag encodes a signed value, so that values near zero of either sign encode as small varints.
+inline uint32_t zigzag_encode(int32_t value)         { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+
+/// @brief How a `DataTable` manages its row storage.
+typedef enum {
+    /// The table starts with room for `initial_size` rows and is reallocated with `initial_size` more rows
+    /// whenever it is full.
+    DATA_TABLE_GROWABLE = 0,
+    /// The table has room for `initial_size` rows. Rows appended to a full table are dropped.
+    DATA_TABLE_FIXED = 1,
+    /// The table has room for `initial_size` rows. Rows appended to a full table overwrite the oldest rows.
+    DATA_TABLE_RING = 2,
+    /// The table keeps two blocks of `initial_size/2` rows in memory and writes each full block to a
+    /// `DataTableSpill`, so the number of rows is not limited by RAM. Set with `DataTable::set_spill()`.
+    DATA_TABLE_STREAMING = 3
+} DataTableMode;
+
+/// @brief Storage that a streaming `DataTable` writes its full blocks of rows to, and reads them back from.
+class DataTableSpill {
+public:
+    virtual ~DataTableSpill()                                           { }
+
+    /// @brief Appends bytes to the end of the storage.
+    /// @returns true if all the bytes were written, false otherwise.
+    virtual bool append(const uint8_t* data, size_t size) = 0;
+
+    /// @brief Reads bytes that were previously appended.
+    /// @param offset The offset of the first byte from the start of the storage.
+    /// @returns true if all the bytes were read, false otherwise.
+    virtual bool read(uint32_t offset, uint8_t* data, size_t size) = 0;
+
+    /// @brief Discards everything in the storage.
+    virtual void clear() = 0;
+};
+
 /// @brief A class that stores data in a table and then can output the contents as a CSV. Class is designed to
 /// collect data as efficiently as possible, then later output the data as a CSV when timing is not so critical.
-/// The table has a fixed number of columns of a consistent type, but the number of rows can grow dynamically. The
-/// table is initialized with a set of column names. Rows are added  to the table using the append_row method. The
-/// append_row method takes the number of columns as th first argument, followed by the values for each column.
+/// The table has a fixed number of columns, but the number of rows can grow dynamically. The table is initialized
+/// with a set of column names. Rows are added  to the table using the append_row method. The append_row method takes
+/// the number of columns as th first argument, followed by the values for each column.
+/// All rows are stored in a single row-major block of memory, so the table costs one heap allocation no matter how
+/// many rows it holds.
+///
+/// `T` is the type values are passed in and read back as. By default every column is also stored as `T`, but a
+/// table can be given a schema of `DataColumnType`s so that each column is stored at its own width, for example a
+/// `uint8_t` PWM value next to a `float` heading. Values are converted to the column's type as by a cast when they
+/// are appended, so they must fit in it.
 template <typename T> class DataTable {
 private:
     int _num_columns;
     String* _column_names;
+    uint8_t* _column_types;
+    uint16_t* _column_offsets;  // byte offset of each column within a row
+    uint16_t _row_size;         // bytes per row
     int _current_size;
     int _initial_size;
+    DataTableMode _mode;
 
     int _num_rows;
-    T** _data;
+    int _first_row;             // storage index of the oldest row, only moves in ring mode
+    int _max_rows;
+    uint32_t _dropped_rows;
+    uint8_t* _data;
+
+    DataTableSpill* _spill;
+    int _spilled_rows;          // rows [0, _spilled_rows) are in the spill, the rest in _data
+    uint8_t* _spill_row;        // space to read one spilled row back into
+
+    // sets up the column names, types and offsets. A null column_types stores every column as T.
+    void init_columns(const String* column_names, const uint8_t* column_types);
+
+    template <typename S, typename V> static void store_as(uint8_t* dest, V value) {
+        S stored = S(value);
+        memcpy(dest, &stored, sizeof(S));
+    }
+    template <typename R, typename S> static R load_as(const uint8_t* src) {
+        S stored;
+        memcpy(&stored, src, sizeof(S));
+        return R(stored);
+    }
+
+    void write_csv_header(Stream& stream) const;
+    void write_csv_value(Stream& stream, const uint8_t* row_data, int column, const DataColumnFormat& format) const;
+    void write_binary_header(Stream& stream, uint8_t flags, const DataColumnFormat* formats) const;
+    void write_delta_varint_rows(Stream& stream, uint32_t* previous, const DataColumnFormat* formats) const;
 
 protected:
     // extends the storage for the table by _initial_size rows. returns true if the storage was extended, false
     // otherwise.
     bool extend(void);
 
+    // reserves storage for a new row according to the table's mode. Returns nullptr if there is no room for the row.
+    uint8_t* reserve_row(void);
+
+    // stores a value in a column of a row, converting it straight from its own type to the column's type so that,
+    // for example, a `uint32_t` timestamp does not lose precision by passing through a 4 byte `double` first.
+    template <typename V> void store_column(uint8_t* row_data, int column, V value) {
+        uint8_t* dest = row_data + _column_offsets[column];
+        switch (_column_types[column]) {
+            case DATA_COLUMN_UINT8:     store_as<uint8_t>(dest, value);     break;
+            case DATA_COLUMN_INT8:      store_as<int8_t>(dest, value);      break;
+            case DATA_COLUMN_UINT16:    store_as<uint16_t>(dest, value);    break;
+            case DATA_COLUMN_INT16:     store_as<int16_t>(dest, value);     break;
+            case DATA_COLUMN_UINT32:    store_as<uint32_t>(dest, value);    break;
+            case DATA_COLUMN_INT32:     store_as<int32_t>(dest, value);     break;
+            case DATA_COLUMN_FLOAT32:   store_as<float>(dest, value);       break;
+            case DATA_COLUMN_FLOAT64:   store_as<double>(dest, value);      break;
+        }
+    }
+
+    // stores the values of a row, letting the compiler unroll and inline the stores.
+    void store_values(uint8_t* row_data, int column)  { }
+    template <typename V, typename... Rest> void store_values(uint8_t* row_data, int column, V value, Rest... rest) {
+        store_column(row_data, column, value);
+        store_values(row_data, column + 1, rest...);
+    }
+
+    // provides the storage of the row at the given index, where index 0 is the oldest row in the table.
+    uint8_t* row(int index)                     { return &_data[((_first_row + index) % _current_size)*_row_size]; }
+    const uint8_t* row(int index) const         { return &_data[((_first_row + index) % _current_size)*_row_size]; }
+
+    // reads a value from a column of a row
+    template <typename R> R load_column_as(const uint8_t* row_data, int column) const;
+    T load_column(const uint8_t* row_data, int column) const    { return load_column_as<T>(row_data, column); }
+
+    // provides the data of the row at the given index, reading it back from the spill if it is no longer in memory.
+    const uint8_t* read_row(int index) const;
+
+    // writes the oldest block of rows in memory to the spill. Returns true if a block was written.
+    bool spill_block(void);
+
+    int rows_in_memory() const                  { return _num_rows - _spilled_rows; }
+    int block_rows() const                      { return _current_size/2; }
+
 public:
     /// @brief Construct a new DataTable object
     /// @param num_columns Number of columns in the table
     /// @param column_names Array of column names
     /// @param initial_size The initail allocted size of the table. If the table grows beyond this size,
     /// the table's storage will be extended by initial_size rows.
-    DataTable(int num_columns, String* column_names, int initial_size = 10);
+    /// @param mode How the table's storage is managed once it is full. See `DataTableMode`.
+    DataTable(int num_columns, String* column_names, int initial_size = 10, DataTableMode mode = DATA_TABLE_GROWABLE);
+
+    /// @brief Construct a new DataTable object with a storage type for each column
+    /// @param num_columns Number of columns in the table
+    /// @param column_names Array of column names
+    /// @param column_types Array of the storage type of each column. `DATA_COLUMN_FLOAT64` columns are stored as
+    /// `DATA_COLUMN_FLOAT32` where `double` is only 4 bytes, as it is on AVR.
+    /// @param initial_size The initail allocted size of the table. See above.
+    /// @param mode How the table's storage is managed once it is full. See `DataTableMode`.
+    DataTable(
+        int num_columns,
+        String* column_names,
+        const DataColumnType* column_types,
+        int initial_size = 10,
+        DataTableMode mode = DATA_TABLE_GROWABLE
+    );
 
-    /// @brief Copy constructor
+    /// @brief Copy constructor. The copy of a streaming table reads its spilled rows from the same spill, so only
+    /// one of the two tables should keep appending rows.
     /// @param other the DataTable to copy
     DataTable(const DataTable<T>& other);
 
     virtual ~DataTable();
 
+    /// @brief Provides the number of columns in the table.
+    int num_columns() const                 { return _num_columns; }
+
+    /// @brief Provides the number of rows in the table.
+    int num_rows() const                    { return _num_rows; }
+
+    /// @brief Provides the number of rows the table can hold before its storage is full.
+    int capacity() const                    { return _current_size; }
+
+    /// @brief Provides the number of rows that were dropped (fixed mode) or overwritten (ring mode) because the
+    /// table was full, or that could not be added because the storage could not be extended.
+    uint32_t dropped_rows() const           { return _dropped_rows; }
+
+    /// @brief Provides the storage type of a column.
+    DataColumnType column_type(int column) const    { return (DataColumnType)_column_types[column]; }
+
+    /// @brief Provides the number of bytes each row takes.
+    size_t row_size() const                 { return _row_size; }
+
+    /// @brief Provides the number of rows that a streaming table has written to its spill.
+    int spilled_rows() const                { return _spilled_rows; }
+
+    /// @brief Provides the number of bytes of memory taken by the rows currently in the table. Rows a streaming
+    /// table has spilled are not counted.
+    size_t bytes_used() const               { return (size_t)rows_in_memory()*_row_size; }
+
+    /// @brief Provides the number of bytes allocated for row storage.
+    size_t bytes_allocated() const          { return (size_t)_current_size*_row_size; }
+
+    /// @brief Provides the largest number of bytes the rows of this table have taken at any one time.
+    size_t high_water_mark() const          { return (size_t)_max_rows*_row_size; }
+
+    /// @brief Removes all rows from the table. The storage is kept, and a streaming table's spill is cleared.
+    void clear();
+
+    /// @brief Turns the table into a streaming table that writes blocks of rows to the given spill. Must be called
+    /// while the table is empty. The table's current capacity, rounded down to an even number of rows, is split into
+    /// two blocks, so size the table such that a block is about one SD card sector.
+    /// @param spill The storage to write rows to. Not owned by the table, and must outlive it.
+    /// @returns true if the table is now streaming, false otherwise.
+    bool set_spill(DataTableSpill* spill);
+
+    /// @brief Lets a streaming table write a full block of rows to its spill. Call this when there is time to spare,
+    /// such as between samples. If both blocks fill up before this is called, the next append writes a block itself.
+    /// @returns true if a block was written, false otherwise.
+    bool service(void)                      { return spill_block(); }
+
     /// @brief adds a row to the table. The number of columns must match the number of columns in the table.
     /// @param num_columns Number of columns in the row
     /// @param ... The values for each column in the row. There should be as many values as there are columns.
     /// @returns true if the row was added, false otherwise.
     bool append_row(int num_columns, ...);
 
+    /// @brief adds a row to the table. Unlike `append_row()` the values are converted to the table's type, so
+    /// they do not need to be cast, and there is no va_list overhead. Use a `FixedDataTable` to have the number of
+    /// values checked at compile time.
+    /// @param values The values for each column in the row. There should be as many values as there are columns.
+    /// @returns true if the row was added, false otherwise.
+    template <typename... Args> bool append(Args... values) {
+        if (sizeof...(Args) != _num_columns) {
+            return false;
+        }
+        uint8_t* new_row = reserve_row();
+        if (new_row == nullptr) {
+            return false;
+        }
+        store_values(new_row, 0, values...);
+        return true;
+    }
+
+    /// @brief Provides a value in the table, converted from the column's type to `T`.
+    /// @param row_index The row, where 0 is the oldest row in the table.
+    /// @param column The column.
+    T value(int row_index, int column) const    { return load_column(read_row(row_index), column); }
+
     /// @brief A function that can be used to format the output of a field in the table.
     /// @param value The value of the field to be formatted
     /// @param col_num The column number of the field to be formatted
@@ -51,28 +352,66 @@ public:
     /// @param stream The `Stream` object to write to.
     /// @param formatter A `FieldFormatter` function that can be used to format the output of a field in the table. Defaults
     /// to a function that simply converts the value to a string using a default encoder for the column type.
-    void write_to_stream(Stream& stream, FieldFormatter formatter = [](T value, int col_num) -> String {
-        return String(value);
-    }) const;
+    void write_to_stream(Stream& stream, FieldFormatter formatter) const;
+
+    /// @brief Write the contents of the table to a stream as a CSV, formatting the values straight from the table's
+    /// storage into a buffer on the stack. Unlike with a `FieldFormatter`, no `String` is allocated per value.
+    /// @param stream The `Stream` object to write to.
+    /// @param formats An array with the `DataColumnFormat` of each column. Defaults to integers for integer columns
+    /// and 2 decimals for real valued columns.
+    void write_to_stream(Stream& stream, const DataColumnFormat* formats = nullptr) const;
+
+    /// @brief Write the contents of the table to a stream in the binary table format. This is much faster than writing
+    /// a CSV as no values are formatted, and the stream is only flushed once at the end.
+    /// @param stream The `Stream` object to write to.
+    /// @param compressed Whether to write the rows with delta and varint coding (`DATA_TABLE_FLAG_DELTA_VARINT`).
+    /// This typically makes the table several times smaller, at the cost of a little processing per value. The
+    /// rows are only compressed if a little working memory can be allocated.
+    /// @param formats With compression, an array with the `DataColumnFormat` of each column, to quantize the real
+    /// valued columns to their decimals (`DATA_TABLE_FLAG_QUANTIZED`), or nullptr to keep their exact bits.
+    void write_binary_to_stream(Stream& stream, bool compressed = false, const DataColumnFormat* formats = nullptr) const;
 };
 
 template <typename T>
-DataTable<T>::DataTable(int num_columns, String* column_names, int initial_size)
+DataTable<T>::DataTable(int num_columns, String* column_names, int initial_size, DataTableMode mode)
+    :   DataTable(num_columns, column_names, nullptr, initial_size, mode)
+{
+}
+
+template <typename T>
+DataTable<T>::DataTable(
+    int num_columns,
+    String* column_names,
+    const DataColumnType* column_types,
+    int initial_size,
+    DataTableMode mode
+)
     :   _num_columns(num_columns),
         _column_names(nullptr),
+        _column_types(nullptr),
+        _column_offsets(nullptr),
+        _row_size(0),
         _current_size(initial_size),
         _initial_size(initial_size),
+        _mode(mode),
         _num_rows(0),
-        _data(nullptr)
+        _first_row(0),
+        _max_rows(0),
+        _dropped_rows(0),
+        _data(nullptr),
+        _spill(nullptr),
+        _spilled_rows(0),
+        _spill_row(nullptr)
 {
-    _column_names = new String[_num_columns];
+    _column_types = new uint8_t[_num_columns];
     for (int i = 0; i < _num_columns; i++) {
-        _column_names[i] = column_names[i];
+        _column_types[i] = (column_types != nullptr) ? column_types[i] : data_column_type<T>();
     }
+    init_columns(column_names, _column_types);
 
-    _data = new T*[_current_size];
-    for (int i = 0; i < _current_size; i++) {
-        _data[i] = new T[_num_columns];
+    _data = new uint8_t[bytes_allocated()];
+    if (_data == NULL) {
+        _current_size = 0;
     }
 }
 
@@ -80,56 +419,94 @@ template <typename T>
 DataTable<T>::DataTable(const DataTable<T>& other)
     :   _num_columns(other._num_columns),
         _column_names(nullptr),
+        _column_types(nullptr),
+        _column_offsets(nullptr),
+        _row_size(0),
         _current_size(other._current_size),
         _initial_size(other._initial_size),
+        _mode(other._mode),
         _num_rows(other._num_rows),
-        _data(nullptr)
+        _first_row(other._first_row),
+        _max_rows(other._max_rows),
+        _dropped_rows(other._dropped_rows),
+        _data(nullptr),
+        _spill(other._spill),
+        _spilled_rows(other._spilled_rows),
+        _spill_row(nullptr)
 {
+    _column_types = new uint8_t[_num_columns];
+    init_columns(other._column_names, other._column_types);
+    _data = new uint8_t[bytes_allocated()];
+    if (_data == NULL) {
+        _current_size = 0;
+        _num_rows = 0;
+        _first_row = 0;
+        _spilled_rows = 0;
+        return;
+    }
+    memcpy(_data, other._data, bytes_allocated());
+    if (_spill != nullptr) {
+        _spill_row = new uint8_t[_row_size];
+    }
+}
+
+template <typename T>
+DataTable<T>::~DataTable() {
+    delete[] _data;
+    delete[] _column_names;
+    delete[] _column_types;
+    delete[] _column_offsets;
+    delete[] _spill_row;
+}
+
+template <typename T>
+void DataTable<T>::init_columns(const String* column_names, const uint8_t* column_types) {
     _column_names = new String[_num_columns];
+    _column_offsets = new uint16_t[_num_columns];
+    _row_size = 0;
     for (int i = 0; i < _num_columns; i++) {
-        _column_names[i] = other._column_names[i];
-    }
-    _data = new T*[_current_size];
-    for (int i = 0; i < _current_size; i++) {
-        _data[i] = new T[_num_columns];
-        if (i < _num_rows ) {
-            for (int j = 0; j < _num_columns; j++) {
-                _data[i][j] = other._data[i][j];
-            }
+        _column_names[i] = column_names[i];
+        uint8_t type = column_types[i];
+        if (type == DATA_COLUMN_FLOAT64 && sizeof(double) != 8) {
+            type = DATA_COLUMN_FLOAT32;
         }
+        _column_types[i] = type;
+        _column_offsets[i] = _row_size;
+        _row_size += data_column_size(type);
     }
 }
 
 template <typename T>
-DataTable<T>::~DataTable() {
-    for (int i = 0; i < _current_size; i++) {
-        delete[] _data[i];
+template <typename R>
+R DataTable<T>::load_column_as(const uint8_t* row_data, int column) const {
+    const uint8_t* src = row_data + _column_offsets[column];
+    switch (_column_types[column]) {
+        case DATA_COLUMN_UINT8:     return load_as<R, uint8_t>(src);
+        case DATA_COLUMN_INT8:      return load_as<R, int8_t>(src);
+        case DATA_COLUMN_UINT16:    return load_as<R, uint16_t>(src);
+        case DATA_COLUMN_INT16:     return load_as<R, int16_t>(src);
+        case DATA_COLUMN_UINT32:    return load_as<R, uint32_t>(src);
+        case DATA_COLUMN_INT32:     return load_as<R, int32_t>(src);
+        case DATA_COLUMN_FLOAT32:   return load_as<R, float>(src);
+        case DATA_COLUMN_FLOAT64:   return load_as<R, double>(src);
+        default:                    return R(0);
     }
-    delete[] _data;
-    delete[] _column_names;
 }
 
 template <typename T>
 bool DataTable<T>::extend(void) {
     int new_size = _current_size + _initial_size;
-    T** new_data = new T*[new_size];
+    uint8_t* new_data = new uint8_t[(size_t)new_size*_row_size];
     if (new_data == NULL) {
         return false;
     }
-    // copy over existing data
-    for (int i = 0; i < _current_size; i++) {
-        new_data[i] = _data[i];
-    }
+    // copy over existing data. Only ring mode moves the first row, and ring mode tables are never extended.
+    memcpy(new_data, _data, bytes_allocated());
 
-    // initialize new rows
-    for (int i = _current_size; i < new_size; i++) {
-        new_data[i] = new T[_num_columns];
-    }
-
-    // delete old data vector
+    // delete old data block
     delete[] _data;
 
-    // update data vector
+    // update data block
     _data = new_data;
     _current_size = new_size;
 
@@ -137,27 +514,112 @@ bool DataTable<T>::extend(void) {
 }
 
 template <typename T>
-bool DataTable<T>::append_row(int num_columns, ...) {
-    if (num_columns != _num_columns) {
+void DataTable<T>::clear() {
+    _num_rows = 0;
+    _first_row = 0;
+    _spilled_rows = 0;
+    if (_spill != nullptr) {
+        _spill->clear();
+    }
+}
+
+template <typename T>
+bool DataTable<T>::set_spill(DataTableSpill* spill) {
+    if (spill == nullptr || _num_rows > 0 || _current_size < 2) {
         return false;
     }
-    if (_num_rows == _current_size) {
-        if (!extend()) {
+    if (_spill_row == nullptr) {
+        _spill_row = new uint8_t[_row_size];
+        if (_spill_row == NULL) {
             return false;
         }
     }
+    // both blocks must be the same size so that a block never wraps around the end of the storage
+    _current_size &= ~1;
+    _mode = DATA_TABLE_STREAMING;
+    _spill = spill;
+    _spill->clear();
+    return true;
+}
+
+template <typename T>
+bool DataTable<T>::spill_block(void) {
+    if (_spill == nullptr || rows_in_memory() < block_rows()) {
+        return false;
+    }
+    if (!_spill->append(row(_spilled_rows), (size_t)block_rows()*_row_size)) {
+        return false;
+    }
+    _spilled_rows += block_rows();
+    return true;
+}
+
+template <typename T>
+const uint8_t* DataTable<T>::read_row(int index) const {
+    if (index >= _spilled_rows) {
+        return row(index);
+    }
+    if (!_spill->read((uint32_t)index*_row_size, _spill_row, _row_size)) {
+        memset(_spill_row, 0, _row_size);
+    }
+    return _spill_row;
+}
+
+template <typename T>
+uint8_t* DataTable<T>::reserve_row(void) {
+    if (_current_size == 0) {
+        return nullptr;
+    }
+    uint8_t* new_row = nullptr;
+    if (_num_rows < _current_size) {
+        new_row = row(_num_rows);
+        _num_rows++;
+    } else if (_mode == DATA_TABLE_STREAMING) {
+        // normally service() has already spilled the older block, otherwise it has to be done now
+        if (rows_in_memory() == _current_size && !spill_block()) {
+            _dropped_rows++;
+            return nullptr;
+        }
+        new_row = row(_num_rows);
+        _num_rows++;
+    } else if (_mode == DATA_TABLE_RING) {
+        // overwrite the oldest row, which makes the next row the oldest
+        new_row = row(0);
+        _first_row = (_first_row + 1) % _current_size;
+        _dropped_rows++;
+    } else if (_mode == DATA_TABLE_GROWABLE && extend()) {
+        new_row = row(_num_rows);
+        _num_rows++;
+    } else {
+        _dropped_rows++;
+        return nullptr;
+    }
+    if (rows_in_memory() > _max_rows) {
+        _max_rows = rows_in_memory();
+    }
+    return new_row;
+}
+
+template <typename T>
+bool DataTable<T>::append_row(int num_columns, ...) {
+    if (num_columns != _num_columns) {
+        return false;
+    }
+    uint8_t* new_row = reserve_row();
+    if (new_row == nullptr) {
+        return false;
+    }
     va_list args;
     va_start(args, num_columns);
     for (int i = 0; i < _num_columns; i++) {
-        _data[_num_rows][i] = va_arg(args, T);
+        store_column(new_row, i, va_arg(args, T));
     }
     va_end(args);
-    _num_rows++;
     return true;
 }
 
 template <typename T>
-void DataTable<T>::write_to_stream(Stream& stream, FieldFormatter formatter) const {
+void DataTable<T>::write_csv_header(Stream& stream) const {
     int last_column = _num_columns - 1;
     for (int i = 0; i < _num_columns; i++) {
         stream.print(_column_names[i]);
@@ -167,10 +629,70 @@ void DataTable<T>::write_to_stream(Stream& stream, FieldFormatter formatter) con
     }
     stream.println("");
     stream.flush();
+}
+
+template <typename T>
+void DataTable<T>::write_csv_value(
+    Stream& stream,
+    const uint8_t* row_data,
+    int column,
+    const DataColumnFormat& format
+) const {
+    char buffer[DATA_FORMAT_BUFFER_SIZE];
+    uint8_t length;
+    uint8_t type = _column_types[column];
+    if (format.decimals == 0 && type <= DATA_COLUMN_INT32) {
+        // integer columns are formatted from their stored value, so large counts and timestamps stay exact. The
+        // unsigned column types have the odd type codes.
+        if (type & 1) {
+            length = format_data_unsigned(buffer, load_column_as<uint32_t>(row_data, column));
+        } else {
+            length = format_data_integer(buffer, load_column_as<int32_t>(row_data, column));
+        }
+    } else {
+        double value = load_column_as<double>(row_data, column);
+        if (format.zero_as_integer && value == 0.0) {
+            buffer[0] = '0';
+            length = 1;
+        } else {
+            length = format_data_fixed(buffer, value, format.decimals);
+        }
+    }
+    stream.write((const uint8_t*)buffer, length);
+}
+
+template <typename T>
+void DataTable<T>::write_to_stream(Stream& stream, const DataColumnFormat* formats) const {
+    write_csv_header(stream);
+    int last_column = _num_columns - 1;
+    for (int i = 0; i < _num_rows; i++) {
+        const uint8_t* row_data = read_row(i);
+        for (int j = 0; j < _num_columns; j++) {
+            if (formats != nullptr) {
+                write_csv_value(stream, row_data, j, formats[j]);
+            } else {
+                DataColumnFormat default_format = {uint8_t(_column_types[j] <= DATA_COLUMN_INT32 ? 0 : 2), false};
+                write_csv_value(stream, row_data, j, default_format);
+            }
+            if (j < last_column) {
+                stream.write(',');
+            }
+        }
+        stream.write('\r');
+        stream.write('\n');
+    }
+    stream.println("");
+    stream.flush();
+}
 
+template <typename T>
+void DataTable<T>::write_to_stream(Stream& stream, FieldFormatter formatter) const {
+    write_csv_header(stream);
+    int last_column = _num_columns - 1;
     for (int i = 0; i < _num_rows; i++) {
+        const uint8_t* row_data = read_row(i);
         for (int j = 0; j < _num_columns; j++) {
-            stream.print(formatter(_data[i][j], j));
+            stream.print(formatter(load_column(row_data, j), j));
             if (j < last_column) {
                 stream.print(",");
             }
@@ -182,4 +704,125 @@ void DataTable<T>::write_to_stream(Stream& stream, FieldFormatter formatter) con
     stream.flush();
 }
 
+template <typename T>
+void DataTable<T>::write_binary_header(Stream& stream, uint8_t flags, const DataColumnFormat* formats) const {
+    stream.print(DATA_TABLE_BINARY_MAGIC);
+    stream.write((uint8_t)DATA_TABLE_BINARY_VERSION);
+    stream.write(flags);
+    stream.write((uint8_t)_num_columns);
+    uint32_t num_rows = _num_rows;
+    stream.write((const uint8_t*)&num_rows, sizeof(num_rows));
+    for (int i = 0; i < _num_columns; i++) {
+        uint8_t name_length = min(_column_names[i].length(), 255u);
+        stream.write(_column_types[i]);
+        stream.write(name_length);
+        stream.write((const uint8_t*)_column_names[i].c_str(), name_length);
+        if (flags & DATA_TABLE_FLAG_QUANTIZED) {
+            stream.write(_column_types[i] >= DATA_COLUMN_FLOAT32 ? formats[i].decimals : (uint8_t)DATA_TABLE_NOT_QUANTIZED);
+        }
+    }
+}
+
+// previous holds the previous row's value of each column, as the bits the deltas are taken of
+template <typename T>
+void DataTable<T>::write_delta_varint_rows(Stream& stream, uint32_t* previous, const DataColumnFormat* formats) const {
+    memset(previous, 0, _num_columns*sizeof(uint32_t));
+    uint8_t buffer[DATA_TABLE_VARINT_MAX_SIZE];
+    for (int i = 0; i < _num_rows; i++) {
+        const uint8_t* row_data = read_row(i);
+        for (int j = 0; j < _num_columns; j++) {
+            uint8_t type = _column_types[j];
+            if (formats != nullptr && type >= DATA_COLUMN_FLOAT32) {
+                uint32_t bits = (uint32_t)quantize_data_value(load_column_as<double>(row_data, j), formats[j].decimals);
+                uint32_t encoded = zigzag_encode((int32_t)(bits - previous[j]));
+                previous[j] = bits;
+                stream.write(buffer, encode_varint(buffer, encoded));
+                continue;
+            }
+            if (type == DATA_COLUMN_FLOAT64) {
+                stream.write(row_data + _column_offsets[j], 8);
+                continue;
+            }
+            uint32_t bits;
+            uint32_t encoded;
+            if (type == DATA_COLUMN_FLOAT32) {
+                memcpy(&bits, row_data + _column_offsets[j], sizeof(bits));
+                encoded = bits ^ previous[j];
+            } else {
+                // even type codes are the signed integers
+                bits = (type & 1) ? load_column_as<uint32_t>(row_data, j) : (uint32_t)load_column_as<int32_t>(row_data, j);
+                encoded = zigzag_encode((int32_t)(bits - previous[j]));
+            }
+            previous[j] = bits;
+            stream.write(buffer, encode_varint(buffer, encoded));
+        }
+    }
+}
+
+template <typename T>
+void DataTable<T>::write_binary_to_stream(Stream& stream, bool compressed, const DataColumnFormat* formats) const {
+    // the working memory for compression is allocated before the header is written, as the header has to say
+    // whether the rows are compressed
+    uint32_t* previous = compressed ? new uint32_t[_num_columns] : nullptr;
+    if (previous == nullptr) {
+        formats = nullptr;
+    }
+    uint8_t flags = (previous != nullptr) ? DATA_TABLE_FLAG_DELTA_VARINT : 0;
+    if (formats != nullptr) {
+        flags |= DATA_TABLE_FLAG_QUANTIZED;
+    }
+    write_binary_header(stream, flags, formats);
+    if (previous != nullptr) {
+        write_delta_varint_rows(stream, previous, formats);
+        delete[] previous;
+    } else {
+        for (int i = 0; i < _num_rows; i++) {
+            stream.write(read_row(i), _row_size);
+        }
+    }
+    stream.flush();
+}
+
+/// @brief A `DataTable` with the number of columns fixed at compile time. The number of column names passed to the
+/// constructor and the number of values passed to `append()` are checked by the compiler.
+template <typename T, int NUM_COLUMNS> class FixedDataTable : public DataTable<T> {
+public:
+    /// @brief Construct a new FixedDataTable object
+    /// @param column_names Array of exactly `NUM_COLUMNS` column names
+    /// @param initial_size The initial allocated number of rows. See `DataTable`.
+    /// @param mode How the table's storage is managed once it is full. See `DataTableMode`.
+    FixedDataTable(String (&column_names)[NUM_COLUMNS], int initial_size = 10, DataTableMode mode = DATA_TABLE_GROWABLE)
+        :   DataTable<T>(NUM_COLUMNS, column_names, initial_size, mode)
+    {
+    }
+
+    /// @brief Construct a new FixedDataTable object with a storage type for each column
+    /// @param column_names Array of exactly `NUM_COLUMNS` column names
+    /// @param column_types Array of exactly `NUM_COLUMNS` column storage types. See `DataTable`.
+    /// @param initial_size The initial allocated number of rows. See `DataTable`.
+    /// @param mode How the table's storage is managed once it is full. See `DataTableMode`.
+    FixedDataTable(
+        String (&column_names)[NUM_COLUMNS],
+        const DataColumnType (&column_types)[NUM_COLUMNS],
+        int initial_size = 10,
+        DataTableMode mode = DATA_TABLE_GROWABLE
+    )
+        :   DataTable<T>(NUM_COLUMNS, column_names, column_types, initial_size, mode)
+    {
+    }
+
+    /// @brief adds a row to the table.
+    /// @param values The values for each column in the row. Must be exactly `NUM_COLUMNS` values.
+    /// @returns true if the row was added, false otherwise.
+    template <typename... Args> bool append(Args... values) {
+        static_assert(sizeof...(Args) == NUM_COLUMNS, "FixedDataTable::append: wrong number of values for the table");
+        uint8_t* new_row = this->reserve_row();
+        if (new_row == nullptr) {
+            return false;
+        }
+        this->store_values(new_row, 0, values...);
+        return true;
+    }
+};
+
 #endif // __DATATABLE_H__
\ No newline at end of file
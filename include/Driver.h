@@ -3,16 +3,80 @@
 #include "Robot.h"
 #include "PointSequence.h"
 
+/// @brief What the driver is currently doing with the path segment it is on.
+typedef enum {
+    DRIVER_IDLE,
+    DRIVER_TURNING,
+    DRIVER_MOVING,
+    DRIVER_AUTOTUNING,
+    DRIVER_FOLLOW_TURNING,          // turning in place to face along the first segment of a followed path
+    DRIVER_FOLLOWING
+} DriverState;
+
+#define DRIVER_COMMAND_SIZE 16
+
 class Driver {
 private:
-    bool _isDriving;
+    DriverState _state;
+    PointSequence _path;
+    uint16_t _segment;              // index of the point the current segment drives to
+    Point _currentPoint;
+    double _currentBearing;
+    double _segmentBearing;
+    double _segmentDistance;
 
     Robot _robot;
+
+    char _command[DRIVER_COMMAND_SIZE];
+    uint8_t _commandLength;
+
+    void set_path(const PointSequence& path);
+    void start_segment();
+    void start_segment_move(int turn_results);
+    void finish_segment(const Point& move_results);
+    void finish_path();
+    void handle_button();
+    void read_commands();
+    void run_command(const char* command);
+    bool start_demo_path(bool follow);
 public:
     Driver();
     virtual ~Driver();
+
+    /// @brief Advances the robot and the path being driven. Call this in the main loop of the program. It never blocks
+    /// for a whole turn or move, so the rest of the program keeps running while the robot drives.
+    ///
+    /// A short press of the button follows the demo path, or cancels driving, and a long press tunes the heading loop.
+    /// The same can be done with the serial commands `follow`, `cancel` and `autotune`, each ending with a newline.
+    /// The command `drive` drives the demo path one segment at a time, and `gains` logs the heading gains. The commands
+    /// `csv`, `binary` and `compressed` set the format data tables are logged in, see `DataLogger::set_table_format()`.
+    /// Tables are logged as CSV until one of these is sent.
     void loop();
 
+    /// @brief Starts driving a path. The path is copied, and driven by subsequent calls to `loop()`.
+    /// @param path The points to drive through, starting at the robot's current position and bearing.
+    /// @return false if the path is too short or the driver is already driving.
+    bool start_path(const PointSequence& path);
+
+    /// @brief Starts following a path continuously, see `Robot::start_follow()`. The path is copied, and followed by
+    /// subsequent calls to `loop()`. If the first segment is well off the robot's current bearing, the robot first turns
+    /// in place to face along it.
+    /// @param path The points to follow, starting at the robot's current position and bearing.
+    /// @return false if the path is too short or the driver is already driving.
+    bool start_follow(const PointSequence& path);
+
+    /// @brief Starts tuning the robot's heading loop, see `Robot::start_heading_autotune()`. The robot drives straight
+    /// ahead for a few meters.
+    /// @return false if the driver is already driving.
+    bool start_autotune();
+
+    /// @brief Is a path being driven, or the heading loop being tuned?
+    bool is_driving() const                 { return _state != DRIVER_IDLE; }
+
+    /// @brief Stops driving the current path, or tuning. The robot's current turn or move is cancelled.
+    void cancel();
+
+    /// @brief Drives a path, blocking until it is complete.
     void trace_path(const PointSequence& path);
 };
 
@@ -0,0 +1,47 @@
+#ifndef __EEPROMRECORD_H__
+#define __EEPROMRECORD_H__
+#include <Arduino.h>
+
+// An EEPROM record is:
+//
+//      marker (1 byte, 0x4B)
+//      version (1 byte)
+//      payload length (1 byte)
+//      the payload
+//      CRC-16/CCITT of the version, length and payload (2 bytes, little endian)
+//
+// A record is only read back if the marker, version, length and checksum all match, so a blank EEPROM, a record from
+// an older firmware or a record that was only partly written are all rejected and the caller keeps its defaults.
+#define EEPROM_RECORD_MARKER 0x4B
+#define EEPROM_RECORD_OVERHEAD 5
+
+// The EEPROM layout. Each record takes its payload plus `EEPROM_RECORD_OVERHEAD` bytes:
+//
+//      0       the heading PID gains, `PIDGains` (17 bytes)
+//      32      the speed model's left/right power ratios, `SpeedModel::saveRatios()` (53 bytes)
+//      96      the turn model's coast factor, `TurnModel::save()` (9 bytes)
+//      1024    and up, scratch records written by the tests, which run on the robot
+//
+// Robot.cpp checks at compile time that the robot's records do not overlap.
+#define HEADING_GAINS_EEPROM_ADDRESS 0
+#define LR_RATIO_EEPROM_ADDRESS 32
+#define TURN_MODEL_EEPROM_ADDRESS 96
+#define EEPROM_END_OF_RECORDS 128
+#define EEPROM_TEST_ADDRESS 1024
+
+/// @brief Reads a record that was written with `write_eeprom_record()`.
+/// @param address The EEPROM address of the record.
+/// @param version The version of the payload layout that is expected.
+/// @param data Where the payload is copied to. It is only written if the record is valid.
+/// @param size The size of the payload.
+/// @return true if a valid record of the version and size was read.
+bool read_eeprom_record(int address, uint8_t version, void* data, uint8_t size);
+
+/// @brief Writes a record. Only the bytes that change are written, to spare the EEPROM's write cycles.
+/// @param address The EEPROM address of the record, which takes `size + EEPROM_RECORD_OVERHEAD` bytes.
+/// @param version The version of the payload layout. Change it whenever the layout of the payload changes.
+/// @param data The payload.
+/// @param size The size of the payload.
+void write_eeprom_record(int address, uint8_t version, const void* data, uint8_t size);
+
+#endif // __EEPROMRECORD_H__
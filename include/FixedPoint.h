@@ -0,0 +1,32 @@
+#ifndef __FIXEDPOINT_H__
+#define __FIXEDPOINT_H__
+#include <Arduino.h>
+
+/// @brief A signed Q16.16 fixed point number: the value times 65536, held in 32 bits. The range is about +/-32767 with
+/// a resolution of 1/65536. The AVR has no floating point unit, so these are much cheaper than doubles (which are 4
+/// byte floats there) for the arithmetic that runs at the control rate.
+typedef int32_t q16_t;
+
+#define Q16_ONE ((q16_t)65536L)
+#define Q16_PI ((q16_t)205887L)
+#define Q16_TWO_PI ((q16_t)411775L)
+#define Q16_HALF_PI ((q16_t)102944L)
+
+/// @brief Converts a constant to Q16.16. Use for constants only, as the conversion uses floating point.
+#define Q16(value) ((q16_t)((value) >= 0 ? (value)*65536.0 + 0.5 : (value)*65536.0 - 0.5))
+
+inline q16_t q16_from_int(int32_t value)                { return value*Q16_ONE; }
+inline q16_t q16_from_double(double value)              { return Q16(value); }
+inline double q16_to_double(q16_t value)                { return value/65536.0; }
+
+/// @brief Multiplies two Q16.16 numbers, rounding to nearest.
+inline q16_t q16_mul(q16_t a, q16_t b)                  { return (q16_t)(((int64_t)a*b + 0x8000) >> 16); }
+
+/// @brief Provides the sine of an angle in radians, from a quarter wave table in PROGMEM with linear interpolation.
+/// Any angle is accepted. The error is less than 3/65536.
+q16_t q16_sin(q16_t radians);
+
+/// @brief Provides the cosine of an angle in radians, with the same accuracy as `q16_sin()`.
+inline q16_t q16_cos(q16_t radians)                     { return q16_sin(radians + Q16_HALF_PI); }
+
+#endif // __FIXEDPOINT_H__
@@ -8,6 +8,7 @@ class HeadingCalculator
 private:
     MPU6050 _mpu;
     float _heading;
+    float _rate;
     unsigned long _lastUpdate;
 
 public:
@@ -26,6 +27,10 @@ public:
     /// @return The heading in degrees. will be between 180 and -180.
     float getHeading()          { return this->update(); }
 
+    /// @brief Returns the turn rate from the latest gyro reading.
+    /// @return The turn rate in degrees per second. Positive is counter-clockwise.
+    float getRate() const       { return _rate; }
+
 };
 
 #endif // __HEADING_CALCULATOR_H__
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __HEADINGFILTER_H__
+#define __HEADINGFILTER_H__
+#include <Arduino.h>
+
+/// @brief Fuses the gyro heading with the heading from the wheel odometry using a one state Kalman filter. The gyro
+/// is smooth and responsive but its bias makes it drift with time, while the wheel heading does not drift with time
+/// but is coarse (one tick of difference between the wheels is several degrees) and its error grows with the distance
+/// driven as the wheels slip.
+///
+/// The filter predicts with the change in the gyro heading, which adds the gyro's drift variance for the time step,
+/// then corrects towards the wheel heading, whose variance is its quantization plus a slip term that grows with the
+/// distance. Each update is a handful of float operations, so it runs at the control rate. Both headings are in
+/// degrees and relative to the same starting heading.
+class HeadingFilter {
+private:
+    float _gyroVarianceRate;
+    float _wheelVariance;
+    float _slipVariancePerMM;
+
+    float _heading;
+    float _variance;
+    float _lastGyroHeading;
+
+public:
+    /// @brief Constructs a heading filter.
+    /// @param gyro_variance_rate The growth of the gyro heading variance, in degrees^2 per second.
+    /// @param wheel_variance The variance of the wheel heading at the start of a motion, in degrees^2.
+    /// @param slip_variance_per_mm The growth of the wheel heading variance with distance, in degrees^2 per mm.
+    HeadingFilter(float gyro_variance_rate, float wheel_variance, float slip_variance_per_mm);
+    virtual ~HeadingFilter();
+
+    /// @brief Restarts the filter with a known heading, at the start of a motion.
+    /// @param heading The heading in degrees, which is also taken as the current gyro heading.
+    void reset(float heading = 0.0);
+
+    /// @brief Advances the heading by the change in the gyro heading.
+    /// @param gyro_heading The current gyro heading in degrees.
+    /// @param dt The time since the last prediction in seconds.
+    void predict(float gyro_heading, float dt);
+
+    /// @brief Corrects the heading with a wheel heading measurement.
+    /// @param wheel_heading The heading from the wheel odometry in degrees.
+    /// @param distance The distance driven since the wheel heading was last exact, in mm.
+    void correct(float wheel_heading, float distance);
+
+    /// @brief Provides the fused heading in degrees.
+    float getHeading() const                            { return _heading; }
+
+    /// @brief Provides the estimated variance of the fused heading in degrees^2.
+    float getVariance() const                           { return _variance; }
+};
+
+#endif // __HEADINGFILTER_H__
@@ -0,0 +1,192 @@
+#ifndef __LOGEVENT_H__
+#define __LOGEVENT_H__
+#include <Arduino.h>
+#include "DataTable.h"
+
+/// @brief The identifiers of the structured log events. Each `*_EVENT` call site uses one of these identifiers, and the
+/// identifier along with the binary arguments is all that is logged. The message format for each event is only kept in
+/// the source, from which `tools/log_events.py` generates the dictionary used to turn the events back into text.
+/// The identifiers are stored in the logs, so existing values must not be changed. Add new events at the end.
+typedef enum {
+    EVENT_ROBOT_TURN_START = 1,
+    EVENT_ROBOT_TURN_TOO_SMALL = 2,
+    EVENT_ROBOT_TURN_HEADING_ERROR = 3,
+    EVENT_ROBOT_TURN_COMPLETE = 4,
+    EVENT_ROBOT_MOVE_START = 5,
+    EVENT_ROBOT_MOVE_INITIAL_POWER = 6,
+    EVENT_ROBOT_MOVE_COMPLETE = 7,
+    EVENT_SPEEDMODEL_INTERPOLATE = 8,          // no longer logged, the speed model uses a lookup table
+    EVENT_SPEEDMODEL_SET_SPEED = 9,            // no longer logged
+    EVENT_DRIVER_SEGMENT_START = 10,
+    EVENT_DRIVER_TURN_COMPLETE = 11,
+    EVENT_DRIVER_MOVE_COMPLETE = 12,
+    EVENT_DATA_TABLE_USAGE = 13,
+    EVENT_CONTROL_TIMER_STATISTICS = 14,
+    EVENT_ROBOT_HEADING_GAINS = 15,
+    EVENT_ROBOT_AUTOTUNE_START = 16,
+    EVENT_ROBOT_AUTOTUNE_COMPLETE = 17,
+    EVENT_ROBOT_AUTOTUNE_FAILED = 18,
+    EVENT_ROBOT_TURN_COAST = 19,
+    EVENT_ROBOT_FOLLOW_START = 20,
+    EVENT_ROBOT_FOLLOW_COMPLETE = 21,
+    EVENT_ROBOT_MOVE_SPILL_STATISTICS = 22
+} LogEventID;
+
+// An event record is:
+//
+//      marker (1 byte, 0xE5, which never appears in the ASCII text log messages)
+//      log level (1 byte)
+//      event ID (2 bytes)
+//      timestamp in milliseconds (4 bytes)
+//      payload length (1 byte)
+//      the payload, which is the arguments, each as a type code (1 byte) followed by the value
+//
+// All multi-byte values are little endian. Numeric arguments use the `DataColumnType` codes, strings use
+// `LOG_EVENT_ARG_STRING` followed by a length byte and the characters.
+#define LOG_EVENT_MARKER 0xE5
+#define LOG_EVENT_HEADER_SIZE 9
+#define LOG_EVENT_MAX_SIZE 64
+#define LOG_EVENT_ARG_STRING 16
+
+// Binary data, such as a binary data table, that shares a stream with the text and event records is sent in frames,
+// so that its bytes are not mistaken for event markers:
+//
+//      marker (1 byte, 0xE6, which never appears in the ASCII text log messages)
+//      length (1 byte, 1 to LOG_FRAME_MAX_SIZE)
+//      the data
+//
+// and the data ends with a frame of length 0. `tools/log_events.py` skips the framed data when it decodes a log, and
+// `tools/dtb_to_csv.py` reads the tables from the frames.
+#define LOG_FRAME_MARKER 0xE6
+#define LOG_FRAME_MAX_SIZE 64
+
+/// @brief Encodes a single structured log event into its binary record.
+class LogEventRecord {
+private:
+    uint8_t _data[LOG_EVENT_MAX_SIZE];
+    uint8_t _size;
+    bool _truncated;
+
+    void add_args()                                     { }
+    template <typename T, typename... Rest> void add_args(T value, Rest... rest) {
+        add_arg(value);
+        add_args(rest...);
+    }
+
+    void add_arg(bool value)                            { add_integer((uint8_t)value); }
+    void add_arg(char value)                            { add_integer((int8_t)value); }
+    void add_arg(signed char value)                     { add_integer(value); }
+    void add_arg(unsigned char value)                   { add_integer(value); }
+    void add_arg(short value)                           { add_integer(value); }
+    void add_arg(unsigned short value)                  { add_integer(value); }
+    void add_arg(int value)                             { add_integer(value); }
+    void add_arg(unsigned int value)                    { add_integer(value); }
+    void add_arg(long value)                            { add_integer((int32_t)value); }
+    void add_arg(unsigned long value)                   { add_integer((uint32_t)value); }
+    void add_arg(float value)                           { add_value(DATA_COLUMN_FLOAT32, &value, sizeof(value)); }
+    void add_arg(double value)                          { add_arg((float)value); }
+    void add_arg(const char* value);
+    void add_arg(const String& value)                   { add_arg(value.c_str()); }
+
+    template <typename T> void add_integer(T value)     { add_value(data_column_type<T>(), &value, sizeof(value)); }
+    void add_value(uint8_t type_code, const void* value, uint8_t length);
+
+public:
+    /// @brief Encodes an event.
+    /// @param level The log level of the event.
+    /// @param event_id The `LogEventID` of the event.
+    /// @param timestamp The time of the event in milliseconds.
+    /// @param args The arguments of the event. Integers, floating point values and strings are supported. Arguments
+    /// that do not fit into the record are dropped and the record is marked as truncated.
+    template <typename... Args>
+    LogEventRecord(uint8_t level, uint16_t event_id, uint32_t timestamp, Args... args)
+        :   _size(LOG_EVENT_HEADER_SIZE),
+            _truncated(false)
+    {
+        _data[0] = LOG_EVENT_MARKER;
+        _data[1] = level;
+        memcpy(&_data[2], &event_id, sizeof(event_id));
+        memcpy(&_data[4], &timestamp, sizeof(timestamp));
+        _data[8] = 0;
+        add_args(args...);
+    }
+
+    /// @brief Provides the encoded record.
+    const uint8_t* data() const                         { return _data; }
+
+    /// @brief Provides the size of the encoded record in bytes.
+    uint8_t size() const                                { return _size; }
+
+    /// @brief Indicates whether some arguments did not fit into the record.
+    bool truncated() const                              { return _truncated; }
+};
+
+/// @brief Writes binary data to a stream in frames, see `LOG_FRAME_MARKER`. The data is collected into a frame
+/// sized buffer, and `finish()` writes the last frame and the end frame.
+class LogFrameStream : public Stream {
+private:
+    Print& _out;
+    uint8_t _frame[LOG_FRAME_MAX_SIZE];
+    uint8_t _size;
+
+    void write_frame() {
+        _out.write((uint8_t)LOG_FRAME_MARKER);
+        _out.write(_size);
+        _out.write(_frame, _size);
+        _size = 0;
+    }
+
+public:
+    LogFrameStream(Print& out)
+        :   _out(out),
+            _size(0)
+    {
+    }
+    virtual ~LogFrameStream()                           { }
+
+    /// @brief Writes the buffered data and the end frame.
+    void finish() {
+        if (_size > 0) {
+            write_frame();
+        }
+        write_frame();
+    }
+
+    virtual size_t write(uint8_t value) override {
+        _frame[_size++] = value;
+        if (_size == LOG_FRAME_MAX_SIZE) {
+            write_frame();
+        }
+        return 1;
+    }
+    virtual int available() override                    { return 0; }
+    virtual int read() override                         { return -1; }
+    virtual int peek() override                         { return -1; }
+    using Print::write;
+};
+
+inline void LogEventRecord::add_value(uint8_t type_code, const void* value, uint8_t length) {
+    if (_truncated || _size + 1 + length > LOG_EVENT_MAX_SIZE) {
+        _truncated = true;
+        return;
+    }
+    _data[_size++] = type_code;
+    memcpy(&_data[_size], value, length);
+    _size += length;
+    _data[8] = _size - LOG_EVENT_HEADER_SIZE;
+}
+
+inline void LogEventRecord::add_arg(const char* value) {
+    size_t length = strlen(value);
+    if (_truncated || _size + 2 + length > LOG_EVENT_MAX_SIZE) {
+        _truncated = true;
+        return;
+    }
+    _data[_size++] = LOG_EVENT_ARG_STRING;
+    _data[_size++] = length;
+    memcpy(&_data[_size], value, length);
+    _size += length;
+    _data[8] = _size - LOG_EVENT_HEADER_SIZE;
+}
+
+#endif // __LOGEVENT_H__
@@ -0,0 +1,55 @@
+#ifndef __MOTIONPROFILE_H__
+#define __MOTIONPROFILE_H__
+#include <Arduino.h>
+
+/// @brief Generates a trapezoidal speed profile for a move of a known distance: the speed ramps up at the acceleration,
+/// holds at the cruise speed and ramps down at the deceleration so that it reaches the final speed at the end of the
+/// move. The ramp-down is planned from the distance that remains rather than from the time, so wheel slip or a slow
+/// start only moves the point where the ramp-down begins. If the move is too short to reach the cruise speed, the
+/// profile is a triangle.
+///
+/// The final speed is the low speed the move ends at, which is slow enough to stop from without a reverse brake. It is
+/// also the lowest speed the profile commands, so that the move starts and does not stall short of the end.
+class MotionProfile {
+private:
+    double _acceleration;
+    double _cruiseSpeed;
+    double _deceleration;
+    double _finalSpeed;
+
+    double _distance;
+    double _speed;
+
+public:
+    /// @brief Constructs a motion profile.
+    /// @param acceleration The acceleration in mm/s^2.
+    /// @param cruise_speed The highest speed in mm/s.
+    /// @param deceleration The deceleration in mm/s^2.
+    /// @param final_speed The speed at the end of the move in mm/s.
+    MotionProfile(double acceleration, double cruise_speed, double deceleration, double final_speed);
+    virtual ~MotionProfile();
+
+    void setCruiseSpeed(double cruise_speed)            { _cruiseSpeed = cruise_speed; }
+    double getCruiseSpeed() const                       { return _cruiseSpeed; }
+
+    /// @brief Starts a move.
+    /// @param distance The length of the move in mm.
+    /// @param initial_speed The speed at the start of the move in mm/s.
+    void start(double distance, double initial_speed = 0.0);
+
+    /// @brief Advances the profile by one time step.
+    /// @param travelled The distance travelled since the start of the move in mm.
+    /// @param dt The time since the last update in seconds.
+    /// @return The commanded speed in mm/s, or zero once the whole distance has been travelled.
+    double update(double travelled, double dt);
+
+    /// @brief Provides the commanded speed from the last update in mm/s.
+    double getSpeed() const                             { return _speed; }
+
+    /// @brief Provides the speed from which the remaining distance can just be covered while decelerating to the final
+    /// speed, in mm/s.
+    /// @param remaining The remaining distance in mm.
+    double stoppingSpeed(double remaining) const;
+};
+
+#endif // __MOTIONPROFILE_H__
@@ -0,0 +1,38 @@
+#ifndef __ODOMETRY_H__
+#define __ODOMETRY_H__
+#include <Arduino.h>
+#include "FixedPoint.h"
+
+/// @brief The motion of the robot over one odometry step, relative to its pose at the start of the step.
+typedef struct {
+    q16_t forward;              // mm along the starting heading
+    q16_t lateral;              // mm across the starting heading, positive is to the left
+    q16_t angle;                // radians of heading change, positive is to the left
+    q16_t radius;               // mm, the turning radius of the inside wheel. 0 when driving straight
+} OdometryStep;
+
+/// @brief Computes the arc the robot drove from the wheel counter deltas over a step, in Q16.16 fixed point. When the
+/// wheels turn by different amounts the robot drives along an arc, whose angle comes from the difference in the wheel
+/// distances and whose radius comes from their ratio. Only integer arithmetic and the `q16_sin()` table are used.
+class FixedOdometry {
+private:
+    q16_t _mmPerTick;
+    q16_t _wheelBase;
+    int32_t _angleFactor;       // radians per tick of wheel difference, in Q8.24 as the factor is small
+
+public:
+    /// @brief Constructs the odometry for a robot.
+    /// @param wheel_circumference The wheel circumference in mm.
+    /// @param disc_holes The number of encoder edges per wheel revolution.
+    /// @param wheel_base The distance between the wheels in mm.
+    FixedOdometry(double wheel_circumference, uint8_t disc_holes, double wheel_base);
+    virtual ~FixedOdometry()                            { }
+
+    /// @brief Computes the motion over a step.
+    /// @param left_delta The left wheel counter change over the step.
+    /// @param right_delta The right wheel counter change over the step.
+    /// @param step Set to the motion over the step.
+    void step(uint16_t left_delta, uint16_t right_delta, OdometryStep& step) const;
+};
+
+#endif // __ODOMETRY_H__
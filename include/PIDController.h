@@ -1,38 +1,231 @@
 #ifndef __PID_CONTROLLER_H__
 #define __PID_CONTROLLER_H__
 #include <Arduino.h>
+#include "FixedPoint.h"
 
-class PIDController
+/// @brief How a PID controller keeps its integral from winding up while the output is limited.
+typedef enum {
+    /// The integral is not advanced on updates where the output is limited and the error would push it further.
+    PID_ANTI_WINDUP_CLAMP = 0,
+    /// The integral is pulled back by the amount the output is limited, times the tracking gain.
+    PID_ANTI_WINDUP_BACK_CALCULATION = 1
+} PIDAntiWindup;
+
+/// @brief The gains of a PID controller.
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+} PIDGains;
+
+/// @brief The arithmetic of a PID controller on floating point values, with time in seconds.
+template <typename T> struct PIDArithmetic {
+    static T from_double(double value)                  { return value; }
+    static double to_double(T value)                    { return value; }
+    static T mul(T a, T b)                              { return a*b; }
+    static T reciprocal(T value)                        { return 1/value; }
+    static T seconds(unsigned long millis)              { return millis/(T)1000; }
+};
+
+/// @brief The arithmetic of a PID controller on Q16.16 fixed point values, with time in seconds.
+struct Q16PIDArithmetic {
+    static q16_t from_double(double value)              { return q16_from_double(value); }
+    static double to_double(q16_t value)                { return q16_to_double(value); }
+    static q16_t mul(q16_t a, q16_t b)                  { return q16_mul(a, b); }
+    static q16_t reciprocal(q16_t value)                { return (q16_t)(((int64_t)Q16_ONE << 16)/value); }
+    static q16_t seconds(unsigned long millis)          { return (q16_t)((((int64_t)millis << 16) + 500)/1000); }
+};
+
+/// @brief A PID controller.
+///
+/// The proportional term acts on a weighted error, `setpoint_weight*setpoint - measurement`, so a weight below 1
+/// softens the response to setpoint changes without changing the response to disturbances. The derivative term acts
+/// on the measurement rather than the error, so setpoint changes do not kick the output, and is low pass filtered.
+/// The integral is kept from winding up while the output is at its limits, see `PIDAntiWindup`.
+///
+/// `T` is the value type, and `Math` provides the arithmetic on it. `PIDController` works in doubles and
+/// `FixedPIDController` in Q16.16 fixed point, which is much faster on the AVR. The time step comes from the
+/// measurement times. The reciprocal of the time step is cached, so with a fixed rate control tick there is no
+/// division per update.
+template <typename T, typename Math = PIDArithmetic<T> >
+class BasicPIDController
 {
 private:
-    double _kp;
-    double _ki;
-    double _kd;
-    double _setPoint;
-    double _min;
-    double _max;
-    double _integral;
-    double _lastError;
+    T _kp;
+    T _ki;
+    T _kd;
+    T _setPoint;
+    T _setPointWeight;
+    T _min;
+    T _max;
+    PIDAntiWindup _antiWindup;
+    T _trackingGain;
+    T _derivativeFilter;
+
+    T _integral;                // the integral term, which already includes the integral gain
+    T _derivative;              // the filtered rate of change of the measurement
+    T _lastMeasurement;
+    T _lastOutput;
     unsigned long _lastTime;
+    unsigned long _lastDtMillis;
+    T _dt;
+    T _inverseDt;
     bool _firstTime;
 
+    T clamp(T value) const                              { return value > _max ? _max : (value < _min ? _min : value); }
+
 public:
-    PIDController(double kp, double ki, double kd, double min, double max);
-    virtual ~PIDController();
+    /// @brief Creates a new PID controller. It has clamping anti-windup, a setpoint weight of 1 and no derivative
+    /// filtering until configured otherwise.
+    /// @param kp The proportional gain
+    /// @param ki The integral gain
+    /// @param kd The derivative gain
+    /// @param min The minimum control signal value to be outputted
+    /// @param max The maximum control signal value to be outputted
+    BasicPIDController(double kp, double ki, double kd, double min, double max);
+    virtual ~BasicPIDController()                       { }
+
+    /// @brief Changes the gains. The integral term, which already includes the integral gain, is kept, so the output
+    /// does not jump.
+    void setGains(double kp, double ki, double kd) {
+        _kp = Math::from_double(kp);
+        _ki = Math::from_double(ki);
+        _kd = Math::from_double(kd);
+    }
+    void setGains(const PIDGains& gains)                { setGains(gains.kp, gains.ki, gains.kd); }
+
+    /// @brief Provides the gains.
+    PIDGains getGains() const {
+        PIDGains gains = {
+            (float)Math::to_double(_kp),
+            (float)Math::to_double(_ki),
+            (float)Math::to_double(_kd)
+        };
+        return gains;
+    }
 
     /// @brief Sets the set point for the PID controller.
     /// @param setPoint The set point.
-    void setSetPoint(double setPoint);
+    void setSetPoint(double setPoint)                   { _setPoint = Math::from_double(setPoint); }
+
+    /// @brief Sets the weight of the set point in the proportional term, usually between 0 and 1.
+    void setSetPointWeight(double weight)               { _setPointWeight = Math::from_double(weight); }
+
+    /// @brief Sets how the integral is kept from winding up.
+    /// @param mode The anti-windup method.
+    /// @param tracking_gain For back calculation, how fast the integral is pulled back, per second. A common choice is
+    /// between ki/kp and sqrt(ki/kd).
+    void setAntiWindup(PIDAntiWindup mode, double tracking_gain = 0.0) {
+        _antiWindup = mode;
+        _trackingGain = Math::from_double(tracking_gain);
+    }
+
+    /// @brief Sets the low pass filter on the derivative.
+    /// @param alpha The weight of each new derivative sample, between 0 and 1. 1 is no filtering.
+    void setDerivativeFilter(double alpha)              { _derivativeFilter = Math::from_double(alpha); }
 
     /// @brief Updates the PID controller with the specified measurement (note, not the error in the measurement).
+    /// The first update after construction or a reset only starts the controller's clock and returns 0. An update
+    /// with the same time as the previous one returns the previous output.
     /// @param measurement The measurement.
     /// @param measurement_millis The time the measurement was taken in milliseconds.
-    double update(double measurement, unsigned long measurement_millis);
+    /// @return The new control signal
+    T update(T measurement, unsigned long measurement_millis);
 
-    /// @brief Resets the PID controller.
+    /// @brief Resets the PID controller, clearing the integral and derivative terms.
     void reset();
 
-    double getCumulativeError() const            { return this->_integral; }
+    /// @brief Provides the integral term of the control signal.
+    T getIntegralTerm() const                           { return _integral; }
+
+    /// @brief Provides the output of the last update.
+    T getOutput() const                                 { return _lastOutput; }
 };
 
-#endif // __PID_CONTROLLER_H__
\ No newline at end of file
+/// @brief A PID controller on doubles.
+typedef BasicPIDController<double> PIDController;
+
+/// @brief A PID controller on Q16.16 fixed point values.
+typedef BasicPIDController<q16_t, Q16PIDArithmetic> FixedPIDController;
+
+template <typename T, typename Math>
+BasicPIDController<T, Math>::BasicPIDController(double kp, double ki, double kd, double min, double max)
+    :   _kp(Math::from_double(kp)),
+        _ki(Math::from_double(ki)),
+        _kd(Math::from_double(kd)),
+        _setPoint(0),
+        _setPointWeight(Math::from_double(1.0)),
+        _min(Math::from_double(min)),
+        _max(Math::from_double(max)),
+        _antiWindup(PID_ANTI_WINDUP_CLAMP),
+        _trackingGain(0),
+        _derivativeFilter(Math::from_double(1.0)),
+        _integral(0),
+        _derivative(0),
+        _lastMeasurement(0),
+        _lastOutput(0),
+        _lastTime(0),
+        _lastDtMillis(0),
+        _dt(0),
+        _inverseDt(0),
+        _firstTime(true)
+{
+}
+
+template <typename T, typename Math>
+T BasicPIDController<T, Math>::update(T measurement, unsigned long measurement_millis)
+{
+    if (_firstTime) {
+        _lastTime = measurement_millis;
+        _lastMeasurement = measurement;
+        _firstTime = false;
+        return 0;
+    }
+    unsigned long dt_millis = measurement_millis - _lastTime;
+    if (dt_millis == 0) {
+        return _lastOutput;
+    }
+    _lastTime = measurement_millis;
+    if (dt_millis != _lastDtMillis) {
+        _lastDtMillis = dt_millis;
+        _dt = Math::seconds(dt_millis);
+        _inverseDt = Math::reciprocal(_dt);
+    }
+
+    T error = _setPoint - measurement;
+    T proportional = Math::mul(_kp, Math::mul(_setPointWeight, _setPoint) - measurement);
+
+    T integral_step = Math::mul(Math::mul(_ki, error), _dt);
+    _integral += integral_step;
+
+    T rate = Math::mul(measurement - _lastMeasurement, _inverseDt);
+    _lastMeasurement = measurement;
+    _derivative += Math::mul(_derivativeFilter, rate - _derivative);
+
+    T signal = proportional + _integral - Math::mul(_kd, _derivative);
+    T output = clamp(signal);
+
+    if (output != signal) {
+        if (_antiWindup == PID_ANTI_WINDUP_BACK_CALCULATION) {
+            _integral += Math::mul(Math::mul(_trackingGain, output - signal), _dt);
+        } else if ((signal > output) == (integral_step > 0)) {
+            // the integral would only push the output further past the limit
+            _integral -= integral_step;
+        }
+    }
+    _lastOutput = output;
+    return output;
+}
+
+template <typename T, typename Math>
+void BasicPIDController<T, Math>::reset()
+{
+    _integral = 0;
+    _derivative = 0;
+    _lastMeasurement = 0;
+    _lastOutput = 0;
+    _lastTime = 0;
+    _firstTime = true;
+}
+
+#endif // __PID_CONTROLLER_H__
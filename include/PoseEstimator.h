@@ -0,0 +1,62 @@
+#ifndef __POSEESTIMATOR_H__
+#define __POSEESTIMATOR_H__
+#include <Arduino.h>
+#include "DataTable.h"
+#include "FixedPoint.h"
+#include "Odometry.h"
+#include "Point.h"
+
+#define POSE_TRAJECTORY_COLUMNS 4
+
+/// @brief Tracks the robot's position and heading in a fixed frame across all of its moves and turns. The frame is the
+/// one paths are given in: y is forward and x is to the right of the robot's starting pose, and the heading is the
+/// bearing in the sense of `Point::absolute_bearing()`, positive counter clockwise from the y axis.
+///
+/// The translation comes from the wheel odometry and the rotation from the gyro. The encoders can not tell the
+/// direction a wheel turns, so the translation is only integrated during moves, and an in-place turn only rotates.
+///
+/// The recent poses are kept in a ring table, which can be logged as the robot's trajectory.
+class PoseEstimator {
+private:
+    q16_t _x;                   // mm
+    q16_t _y;                   // mm
+    q16_t _heading;             // radians, between -pi and pi
+    FixedDataTable<double, POSE_TRAJECTORY_COLUMNS> _trajectory;
+
+public:
+    /// @brief Constructs a pose estimator at the origin.
+    /// @param trajectory_rows The number of the most recent poses the trajectory keeps.
+    PoseEstimator(int trajectory_rows);
+    virtual ~PoseEstimator();
+
+    /// @brief Sets the pose and clears the trajectory.
+    void reset(double x = 0.0, double y = 0.0, double heading = 0.0);
+
+    /// @brief Moves the pose by an odometry step.
+    /// @param step The motion over the step, relative to the pose at its start.
+    /// @param heading_change The change in heading over the step, in radians.
+    void update(const OdometryStep& step, q16_t heading_change);
+
+    /// @brief Rotates the pose in place.
+    /// @param heading_change The change in heading in radians.
+    void rotate(q16_t heading_change);
+
+    /// @brief Adds the current pose to the trajectory.
+    /// @param timestamp The time of the pose in milliseconds.
+    void record(uint32_t timestamp);
+
+    double x() const                                    { return q16_to_double(_x); }
+    double y() const                                    { return q16_to_double(_y); }
+    Point position() const                              { return Point(x(), y()); }
+
+    /// @brief Provides the heading in degrees, between -180 and 180.
+    double heading() const                              { return q16_to_double(_heading)*(180.0/PI); }
+
+    /// @brief Provides the recorded poses, as timestamp, x, y and heading in degrees.
+    const DataTable<double>& trajectory() const         { return _trajectory; }
+
+    /// @brief The formats to log the trajectory with.
+    static const DataColumnFormat TRAJECTORY_FORMATS[POSE_TRAJECTORY_COLUMNS];
+};
+
+#endif // __POSEESTIMATOR_H__
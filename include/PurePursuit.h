@@ -0,0 +1,73 @@
+#ifndef __PUREPURSUIT_H__
+#define __PUREPURSUIT_H__
+#include <Arduino.h>
+#include "PointSequence.h"
+
+/// @brief What the robot should do to follow the path, from `PurePursuit::update()`.
+typedef struct {
+    float curvature;            // 1/mm, positive turns left
+    float speed;                // mm/s
+    float remaining;            // mm along the path to its end
+} PursuitCommand;
+
+/// @brief Follows a path of straight segments continuously with pure pursuit: the robot steers along the arc that
+/// takes it to the point a fixed lookahead distance further along the path, so corners are taken as arcs instead of
+/// stopping and turning in place. The lookahead point is measured along the path from the robot's projection onto it,
+/// so the robot follows each segment in order even where the path crosses itself.
+///
+/// The speed is the cruise speed, except where the path requires it to be lower: it is limited so that the sideways
+/// acceleration on the current arc stays within bounds, it comes down ahead of each corner to the speed at which the
+/// corner's arc can be taken, and it comes down to the final speed at the end of the path.
+///
+/// The positions are in the frame of the `PoseEstimator`, with headings in degrees counter clockwise from the y axis.
+class PurePursuit {
+private:
+    float _lookahead;
+    float _cruiseSpeed;
+    float _finalSpeed;
+    float _deceleration;
+    float _lateralAcceleration;
+
+    const PointSequence* _path;
+    uint16_t _segment;          // index of the point the segment the robot is on starts at
+    bool _complete;
+
+    float segmentLength(uint16_t segment) const;
+    float cornerSpeed(uint16_t point) const;
+public:
+    /// @brief Constructs a path follower.
+    /// @param lookahead The distance along the path to the point that is steered for, in mm. A longer lookahead
+    /// cuts the corners more, with gentler arcs.
+    /// @param cruise_speed The highest speed in mm/s.
+    /// @param final_speed The speed at the end of the path, and the lowest speed, in mm/s.
+    /// @param deceleration The deceleration for the corners and the end of the path in mm/s^2.
+    /// @param lateral_acceleration The largest sideways acceleration on an arc in mm/s^2.
+    PurePursuit(
+        float lookahead,
+        float cruise_speed,
+        float final_speed,
+        float deceleration,
+        float lateral_acceleration
+    );
+    virtual ~PurePursuit();
+
+    /// @brief Starts following a path. The path is not copied, so it must not change until the path is complete.
+    /// @param path The path, which starts at the robot's position.
+    void start(const PointSequence& path);
+
+    /// @brief Works out the arc and speed from the robot's pose.
+    /// @param x The robot's x coordinate in mm.
+    /// @param y The robot's y coordinate in mm.
+    /// @param heading The robot's heading in degrees.
+    /// @param command Filled with the arc and speed to drive.
+    /// @return false once the robot has reached the end of the path, in which case the command is not changed.
+    bool update(float x, float y, float heading, PursuitCommand& command);
+
+    /// @brief Has the robot reached the end of the path?
+    bool is_complete() const                            { return _complete; }
+
+    /// @brief Provides the index of the point the segment the robot is on starts at.
+    uint16_t segment() const                            { return _segment; }
+};
+
+#endif // __PUREPURSUIT_H__
@@ -0,0 +1,85 @@
+#ifndef __RELAYAUTOTUNER_H__
+#define __RELAYAUTOTUNER_H__
+#include <Arduino.h>
+#include "PIDController.h"
+
+/// @brief The progress of a relay autotuning experiment.
+typedef enum {
+    AUTOTUNE_IDLE,
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_COMPLETE,
+    AUTOTUNE_FAILED
+} AutotuneState;
+
+/// @brief Finds PID gains for a loop with a relay feedback experiment (Astrom and Hagglund). While it runs, the autotuner
+/// takes the place of the PID controller and drives the loop with a relay: the output is `+amplitude` while the
+/// measurement is below the set point and `-amplitude` once it is above, with some hysteresis against noise. Most loops
+/// then settle into an oscillation at their ultimate period, and the amplitude of the oscillation gives the ultimate gain,
+/// `4*amplitude/(pi*sqrt(a^2 - hysteresis^2))` for an oscillation amplitude `a`.
+///
+/// The first cycle is a transient and is skipped, then the ultimate gain and period are averaged over the following
+/// cycles. The gains use the Tyreus-Luyben rules, which are less aggressive than Ziegler-Nichols and suit integrating
+/// loops, such as the heading, where the Ziegler-Nichols gains ring.
+class RelayAutotuner {
+private:
+    double _relayAmplitude;
+    double _hysteresis;
+    uint8_t _cycles;
+    unsigned long _timeoutMillis;
+
+    AutotuneState _state;
+    double _setPoint;
+    double _output;
+    unsigned long _startMillis;
+    bool _firstUpdate;
+    unsigned long _cycleStartMillis;    // the time the output last switched to negative
+    uint8_t _startedCycles;
+    double _cycleMax;
+    double _cycleMin;
+    double _amplitudeSum;
+    unsigned long _periodSumMillis;
+    uint8_t _measuredCycles;
+
+    double _ultimateGain;
+    double _ultimatePeriod;
+
+    void finish_cycle(unsigned long now);
+    void finish();
+public:
+    /// @brief Constructs an autotuner.
+    /// @param relay_amplitude The relay output, in the units of the controller's output.
+    /// @param hysteresis How far the measurement must cross the set point before the relay switches.
+    /// @param cycles The number of oscillation cycles to measure after the first one.
+    /// @param timeout_millis The longest the experiment may run before it fails.
+    RelayAutotuner(double relay_amplitude, double hysteresis, uint8_t cycles, unsigned long timeout_millis);
+    virtual ~RelayAutotuner();
+
+    /// @brief Starts an experiment.
+    /// @param set_point The set point to oscillate around.
+    /// @param start_millis The time the experiment starts in milliseconds, on the same clock as the measurement times.
+    /// If the first measurement is earlier, its clock is taken to have been restarted, and the time out counts from it.
+    void start(double set_point, unsigned long start_millis);
+
+    /// @brief Stops the experiment. A running experiment fails.
+    void stop();
+
+    /// @brief Updates the experiment with a measurement.
+    /// @param measurement The measurement.
+    /// @param measurement_millis The time the measurement was taken in milliseconds.
+    /// @return The relay output to apply to the loop, 0 once the experiment is no longer running.
+    double update(double measurement, unsigned long measurement_millis);
+
+    AutotuneState state() const                         { return _state; }
+    bool is_running() const                             { return _state == AUTOTUNE_RUNNING; }
+
+    /// @brief Provides the ultimate gain. Valid once the experiment is complete.
+    double ultimateGain() const                         { return _ultimateGain; }
+
+    /// @brief Provides the ultimate period in seconds. Valid once the experiment is complete.
+    double ultimatePeriod() const                       { return _ultimatePeriod; }
+
+    /// @brief Provides the PID gains from the ultimate gain and period. Valid once the experiment is complete.
+    PIDGains gains() const;
+};
+
+#endif // __RELAYAUTOTUNER_H__
@@ -0,0 +1,149 @@
+#ifndef __RINGBUFFER_H__
+#define __RINGBUFFER_H__
+#include <Arduino.h>
+
+/// @brief A fixed capacity FIFO of bytes that can be written to like any other `Print` object. The buffer is intended
+/// to collect output in RAM so that it can be handed to a slow device (such as the SD card) in large chunks. The storage
+/// is allocated inline, so no heap is used. Bytes that do not fit into the buffer are dropped and counted.
+template <uint16_t CAPACITY> class RingBuffer : public Print {
+private:
+    uint8_t _data[CAPACITY];
+    uint16_t _head;         // index of the next byte to be written
+    uint16_t _tail;         // index of the next byte to be read
+    uint16_t _size;
+    uint32_t _dropped_bytes;
+
+public:
+    RingBuffer();
+    virtual ~RingBuffer()                               { }
+
+    /// @brief Provides the number of bytes currently held in the buffer.
+    uint16_t size() const                               { return _size; }
+
+    /// @brief Provides the total number of bytes the buffer can hold.
+    uint16_t capacity() const                           { return CAPACITY; }
+
+    /// @brief Provides the number of bytes that can be written before the buffer is full.
+    uint16_t free_space() const                         { return CAPACITY - _size; }
+
+    bool is_empty() const                               { return _size == 0; }
+    bool is_full() const                                { return _size == CAPACITY; }
+
+    /// @brief Provides the number of bytes that were dropped because the buffer was full.
+    uint32_t dropped_bytes() const                      { return _dropped_bytes; }
+    void reset_dropped_bytes()                          { _dropped_bytes = 0; }
+
+    /// @brief Discards the contents of the buffer. The dropped byte count is not changed.
+    void clear();
+
+    /// @brief Provides a pointer to the oldest byte in the buffer. Use with `contiguous_size()` to hand the buffered
+    /// bytes to a device without copying them, then call `consume()` with the number of bytes that were written.
+    const uint8_t* read_pointer() const                 { return &_data[_tail]; }
+
+    /// @brief Provides the number of bytes that can be read starting at `read_pointer()` before the buffer wraps.
+    uint16_t contiguous_size() const;
+
+    /// @brief Removes bytes from the front of the buffer.
+    /// @param count The number of bytes to remove. Clamped to the current size.
+    void consume(uint16_t count);
+
+    /// @brief Removes and returns the oldest byte in the buffer.
+    /// @return The byte, or -1 if the buffer is empty.
+    int read();
+
+    /// @brief Returns the oldest byte in the buffer without removing it.
+    /// @return The byte, or -1 if the buffer is empty.
+    int peek() const;
+
+    // Print interface
+    virtual size_t write(uint8_t value) override;
+    virtual size_t write(const uint8_t* buffer, size_t size) override;
+    virtual int availableForWrite() override            { return free_space(); }
+    using Print::write;
+};
+
+template <uint16_t CAPACITY>
+RingBuffer<CAPACITY>::RingBuffer()
+    :   _head(0),
+        _tail(0),
+        _size(0),
+        _dropped_bytes(0)
+{
+}
+
+template <uint16_t CAPACITY>
+void RingBuffer<CAPACITY>::clear() {
+    _head = 0;
+    _tail = 0;
+    _size = 0;
+}
+
+template <uint16_t CAPACITY>
+uint16_t RingBuffer<CAPACITY>::contiguous_size() const {
+    if (_size == 0) {
+        return 0;
+    }
+    if (_tail < _head) {
+        return _head - _tail;
+    }
+    return CAPACITY - _tail;
+}
+
+template <uint16_t CAPACITY>
+void RingBuffer<CAPACITY>::consume(uint16_t count) {
+    if (count > _size) {
+        count = _size;
+    }
+    _tail = (_tail + count) % CAPACITY;
+    _size -= count;
+}
+
+template <uint16_t CAPACITY>
+int RingBuffer<CAPACITY>::read() {
+    if (_size == 0) {
+        return -1;
+    }
+    uint8_t value = _data[_tail];
+    consume(1);
+    return value;
+}
+
+template <uint16_t CAPACITY>
+int RingBuffer<CAPACITY>::peek() const {
+    if (_size == 0) {
+        return -1;
+    }
+    return _data[_tail];
+}
+
+template <uint16_t CAPACITY>
+size_t RingBuffer<CAPACITY>::write(uint8_t value) {
+    if (_size == CAPACITY) {
+        _dropped_bytes++;
+        return 0;
+    }
+    _data[_head] = value;
+    _head = (_head + 1) % CAPACITY;
+    _size++;
+    return 1;
+}
+
+template <uint16_t CAPACITY>
+size_t RingBuffer<CAPACITY>::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (written < size && _size < CAPACITY) {
+        // copy as much as possible up to the end of the storage array
+        uint16_t chunk = (_head < _tail) ? _tail - _head : CAPACITY - _head;
+        if (chunk > size - written) {
+            chunk = size - written;
+        }
+        memcpy(&_data[_head], buffer + written, chunk);
+        _head = (_head + chunk) % CAPACITY;
+        _size += chunk;
+        written += chunk;
+    }
+    _dropped_bytes += size - written;
+    return written;
+}
+
+#endif // __RINGBUFFER_H__
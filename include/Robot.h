@@ -5,19 +5,117 @@
 #include "SpeedModel.h"
 #include "Point.h"
 #include "HeadingCalculator.h"
+#include "HeadingFilter.h"
+#include "MotionProfile.h"
+#include "Odometry.h"
+#include "PoseEstimator.h"
+#include "PurePursuit.h"
+#include "RelayAutotuner.h"
+#include "TurnModel.h"
+#include "ControlTimer.h"
+#include "DataTable.h"
+#include "PIDController.h"
+#include "SDTableSpill.h"
+#include "WheelEncoder.h"
+#include "WheelSpeedController.h"
+
+#define TURN_DATA_COLUMNS 7
+#define MOVE_DATA_COLUMNS 21
+
+/// @brief What the robot's motion state machine is currently doing.
+typedef enum {
+    MOTION_IDLE,
+    MOTION_TURNING,
+    MOTION_TURN_COASTING,
+    MOTION_MOVING,
+    MOTION_BRAKING,
+    MOTION_FOLLOWING
+} MotionState;
+
+/// @brief The outcome of the most recent motion command.
+typedef enum {
+    MOTION_STATUS_NONE,         // no motion command has been started
+    MOTION_STATUS_RUNNING,
+    MOTION_STATUS_COMPLETE,
+    MOTION_STATUS_CANCELLED
+} MotionStatus;
+
+/// @brief A press of the robot button.
+typedef enum {
+    BUTTON_NONE,
+    BUTTON_SHORT_PRESS,         // reported when the button is released
+    BUTTON_LONG_PRESS           // reported once the button has been held long enough, while it is still held
+} ButtonEvent;
 
 void leftRotationCounterISR();
 void rightRotationCounterISR();
+void sampleControlTick(ControlTick& tick);
 
 class Robot {
 private:
     bool _buttonPressed;
+    bool _buttonLongPress;
+    unsigned long _buttonPressMillis;
+    ButtonEvent _buttonEvent;
     L298NX2 _motorController;
     SpeedModel _speedModel;
     HeadingCalculator _headingCalculator;
+    ControlTimer _controlTimer;
+    PIDController _headingController;
+    RelayAutotuner _headingAutotuner;
+    bool _saveHeadingGains;     // the autotuned gains are written to the EEPROM at the end of the move
+    TurnModel _turnModel;
+    WheelSpeedController _leftSpeedController;
+    WheelSpeedController _rightSpeedController;
+    MotionProfile _moveProfile;
+    FixedOdometry _odometry;
+    PoseEstimator _pose;
+    HeadingFilter _headingFilter;
+    float _poseHeading;         // the fused heading at the last pose update
+
+    MotionState _motionState;
+    MotionStatus _motionStatus;
+    bool _motionCancelled;
+
+    // turn state
+    int _turnDegrees;
+    int _turnResult;
+    uint8_t _turnPower;
+    float _turnCutoffHeading;
+    float _turnCutoffRate;
+    unsigned long _turnCutoffMillis;
+    FixedDataTable<double, TURN_DATA_COLUMNS>* _turnData;
+
+    // move state
+    uint32_t _moveTargetTicks;
+    uint32_t _lastLeftWheelCounter;
+    uint32_t _lastRightWheelCounter;
+    uint32_t _lastTelemetryTick;
+    q16_t _forwardDistance;
+    q16_t _horizontalDisplacement;
+    q16_t _wheelBearing;
+    double _gyroHeading;
+    double _controlSignal;
+    unsigned long _moveEndMillis;
+    Point _moveResult;
+    FixedDataTable<double, MOVE_DATA_COLUMNS>* _moveData;
+    SDTableSpill* _moveDataSpill;
+    bool _moveDataSpilled;              // a block was spilled after the last control tick
+    uint16_t _moveDataSpills;
+    uint32_t _moveDataSpillOverruns;    // ticks missed right after a spill
 
-    volatile uint32_t _leftWheelCounter;
-    volatile uint32_t _rightWheelCounter;
+    // path following state
+    PurePursuit _pursuit;
+    PursuitCommand _pursuitCommand;
+    double _followSpeed;
+
+    // reverse brake state
+    unsigned long _brakeStartMillis;
+    uint8_t _brakePowerA;
+    uint8_t _brakePowerB;
+
+    WheelEncoder _leftWheelEncoder;
+    WheelEncoder _rightWheelEncoder;
 
     unsigned long _statusLEDUpdateTime;
     unsigned long _statusLEDUpdateInterval;
@@ -25,11 +123,41 @@ private:
 protected:
     friend void leftRotationCounterISR();
     friend void rightRotationCounterISR();
+    friend void sampleControlTick(ControlTick& tick);
 
     void handleLeftWheelCounterISR();
     void handleRightWheelCounterISR();
 
-    void reverse_brake();
+    void update_button();
+    void update_motion();
+    void update_turn();
+    void set_turn_power(uint8_t power);
+    void start_turn_coast(float heading, float rate);
+    void update_turn_coast();
+    void finish_turn(double heading_error);
+    void update_move();
+    void update_move_telemetry(const ControlTick& tick);
+    double update_heading_filter(const ControlTick& tick);
+    void drive_wheels(double left_speed, double right_speed, unsigned long tick_millis);
+    void step_pose(uint32_t left_counter, uint32_t right_counter, unsigned long millis, OdometryStep& step);
+    void service_move_data(const ControlTick& tick);
+    void end_move();
+    void finish_move();
+    void finish_heading_autotune();
+    void start_wheel_speed_control();
+    void update_follow();
+    void end_follow();
+    void start_reverse_brake();
+    void update_reverse_brake();
+
+    /// @brief Loads the heading gains saved by the last autotune, if there are any.
+    void load_heading_gains();
+
+    /// @brief Provides the fused heading change since the last call, in radians, for the pose.
+    q16_t take_pose_heading_change();
+
+    /// @brief Resets the gyro heading to zero at the start of a motion, keeping the pose's heading.
+    void reset_heading();
 public:
     static Robot* instance;
 
@@ -46,18 +174,91 @@ public:
     unsigned long rightWheelCounter() const;
     void resetWheelCounters();
 
-    /// @brief IS the robot button newly pressed?
-    /// @return true if the button is pressed, false otherwise.
-    bool buttonPressed();
+    /// @brief Provides the wheel encoders, for the wheel speeds measured from the encoder edge periods.
+    const WheelEncoder& leftWheelEncoder() const        { return _leftWheelEncoder; }
+    const WheelEncoder& rightWheelEncoder() const       { return _rightWheelEncoder; }
+
+    /// @brief Provides the robot's pose, which is tracked across all moves and turns.
+    const PoseEstimator& pose() const                   { return _pose; }
+
+    /// @brief Provides the heading filter, whose heading is the gyro heading fused with the wheel heading since the
+    /// start of the current (or last) motion.
+    const HeadingFilter& headingFilter() const          { return _headingFilter; }
+
+    /// @brief Sets the robot's pose and clears its trajectory.
+    /// @param x The x coordinate in mm, positive to the right.
+    /// @param y The y coordinate in mm, positive forward.
+    /// @param heading The heading in degrees, positive counter clockwise from the y axis.
+    void reset_pose(double x = 0.0, double y = 0.0, double heading = 0.0);
+
+    /// @brief Takes the latest press of the robot button. Each press is only reported once.
+    /// @return The press, or `BUTTON_NONE` if there has not been one since the last call.
+    ButtonEvent buttonEvent();
+
+    /// @brief Starts turning the robot by the specified number of degrees and returns immediately. The turn is advanced by
+    /// `loop()`, and its progress can be polled with `motion_status()`. The power tapers off as the turn nears its
+    /// target, and is cut early by the angle the robot is predicted to coast, see `TurnModel`.
+    /// @param degrees The number of degrees to turn, as for `turn()`.
+    /// @return false if the robot is already in motion, in which case nothing is started.
+    bool start_turn(int degrees);
+
+    /// @brief Starts moving the robot by the specified number of millimeters and returns immediately. The move follows a
+    /// trapezoidal speed profile that ends at a low speed at the target distance. It is advanced by `loop()`, and its
+    /// progress can be polled with `motion_status()`.
+    /// @param millimeters The number of millimeters to move, as for `move()`.
+    /// @return false if the robot is already in motion, in which case nothing is started.
+    bool start_move(int millimeters);
+
+    /// @brief Starts following a path continuously, and returns immediately. Corners are taken as arcs, and the speed
+    /// only comes down where the corners or the end of the path require it (see `PurePursuit`). The path is followed
+    /// with the pose, so the pose should be reset to the path's first point, with the robot facing roughly along the
+    /// first segment. The follow is advanced by `loop()`, and its progress can be polled with `motion_status()`.
+    /// @param path The path. It is not copied, so it must not change until the robot is no longer in motion.
+    /// @return false if the robot is already in motion or the path is too short, in which case nothing is started.
+    bool start_follow(const PointSequence& path);
+
+    /// @brief Starts a straight move that tunes the heading loop. For the first part of the move a relay drives the
+    /// heading back and forth around straight ahead, and the gains are derived from the oscillation (see
+    /// `RelayAutotuner`). The new gains are saved to the EEPROM, where they are loaded from at start up, and steer the
+    /// rest of the move. If the oscillation can not be measured the gains are left unchanged.
+    /// @return false if the robot is already in motion, in which case nothing is started.
+    bool start_heading_autotune();
+
+    /// @brief Is the heading loop being autotuned?
+    bool is_autotuning() const              { return _headingAutotuner.is_running(); }
+
+    /// @brief Provides the gains of the heading loop.
+    PIDGains heading_gains() const          { return _headingController.getGains(); }
+
+    /// @brief Logs the gains of the heading loop.
+    void log_heading_gains() const;
+
+    /// @brief Provides the status of the most recently started turn or move.
+    MotionStatus motion_status() const;
+
+    /// @brief Is a turn or move (or the brake at the end of a move) still in progress?
+    bool is_in_motion() const               { return _motionState != MOTION_IDLE; }
+
+    /// @brief Stops the current turn or move. A turn stops immediately, unless its power is already cut, in which case
+    /// it finishes coasting. A move stops its motors and finishes with the reverse brake, and a path follow stops its
+    /// motors. The motion status becomes `MOTION_STATUS_CANCELLED` once the robot is idle.
+    void cancel_motion();
+
+    /// @brief The number of degrees the most recent turn actually turned. Valid once the turn is no longer running.
+    int turn_result() const                 { return _turnResult; }
+
+    /// @brief The point the most recent move reached relative to its start, as returned by `move()`. Valid once the move
+    /// is no longer running.
+    Point move_result() const               { return _moveResult; }
 
-    /// @brief turn the robot by the specified number of degrees.
+    /// @brief turn the robot by the specified number of degrees. This blocks until the turn is complete.
     /// @param degrees The number of degrees to turn. A positive number turns the robot counter clockise (left), and a negative
     /// number turns the robot clockwise (right) (all per the right hand rule).
     /// @return returns the number of degrees the robot actually turned. This is useful for keeping track of the robot's orientation.
     int turn(int degrees);
 
     /// @brief move the robot forward or backward by the specified number of millimeters. A positive number moves the robot
-    /// forward, and a negative number moves the robot backward.
+    /// forward, and a negative number moves the robot backward. This blocks until the move is complete.
     /// @param millimeters The number of millimeters to move the robot.
     /// @return Returns the point the robot moved to relative to it's starting point, with axis y being the forward motion and axis X being any
     /// horizontal deviation. This is useful for keeping track of the robot's position. A perfect forward motion would result in a point
@@ -0,0 +1,40 @@
+#ifndef __SDTABLESPILL_H__
+#define __SDTABLESPILL_H__
+#include <Arduino.h>
+#include <SD.h>
+#include "DataTable.h"
+
+#define SD_TABLE_SPILL_FILE_NAME_SIZE 24
+#define SD_TABLE_SPILL_SECTOR_SIZE 512
+
+/// @brief A `DataTableSpill` that keeps the spilled rows of a streaming `DataTable` in a scratch file on the SD card.
+/// The file is replaced when the spill is created and removed when it is destroyed.
+///
+/// Each block the table appends is padded to a 512 byte sector, so every block starts on a sector boundary and is
+/// written to the card as one whole sector, without reading back and rewriting the sectors on either side of it.
+/// All blocks must have the same size, of at most one sector.
+class SDTableSpill : public DataTableSpill {
+private:
+    char _fileName[SD_TABLE_SPILL_FILE_NAME_SIZE];
+    File _file;
+    size_t _blockSize;          // size of the blocks appended so far, 0 before the first one
+    uint32_t _numBlocks;
+
+    void open(void);
+
+public:
+    /// @brief Creates the spill file.
+    /// @param fileName The name of the scratch file. Must be a valid 8.3 path, such as "log/move.tmp".
+    SDTableSpill(const char* fileName);
+    virtual ~SDTableSpill();
+
+    /// @brief Indicates whether the spill file could be created, which requires an SD card.
+    bool is_open()                              { return (bool)_file; }
+
+    // DataTableSpill interface
+    virtual bool append(const uint8_t* data, size_t size) override;
+    virtual bool read(uint32_t offset, uint8_t* data, size_t size) override;
+    virtual void clear() override;
+};
+
+#endif // __SDTABLESPILL_H__
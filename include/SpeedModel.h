@@ -3,15 +3,37 @@
 #include <Arduino.h>
 #include <PIDController.h>
 
+#define POWER_RATIO_COUNT 12
+
+/// @brief Sets the left and right motor powers for an average power, with the right power scaled by the left/right
+/// ratio that makes both wheels turn at the same speed. The ratio is interpolated from a table of ratios at several
+/// power levels. The right power for every power from 0 to 255 is worked out whenever the ratios change, so setting a
+/// speed is only a lookup and can be done on every control tick.
+///
+/// The table starts out as the ratios measured by hand, and is learned online from the wheel counts of straight moves,
+/// as the motor mismatch changes with the battery level and wear. The learned table can be saved to and loaded from
+/// the EEPROM.
 class SpeedModel {
 private:
     uint32_t _wheelDiscHoles;
 
-    double _averageSpeed;
-    double _lrRatio;
     int _speedA;
     int _speedB;
 
+    float _lrRatios[POWER_RATIO_COUNT];
+    uint8_t _speedBTable[256];      // the right power for each power, so setting a speed is a table lookup
+    bool _lrRatiosChanged;
+
+    // the observations since the last learning step
+    uint32_t _observedLeftPower;
+    uint32_t _observedRightPower;
+    uint16_t _observationCount;
+    uint32_t _observedLeftTicks;
+    uint32_t _observedRightTicks;
+
+    double interpolateRatio(uint8_t speed, int& index, double& fraction) const;
+    void buildSpeedTable(uint8_t first_power, uint8_t last_power);
+
 public:
     SpeedModel(
         uint32_t wheelDiscHoles = 20
@@ -20,11 +42,40 @@ public:
 
     void reset();
 
+    /// @brief Sets the left power to the speed, and the right power to the speed scaled by the left/right ratio.
+    /// Speeds below the lowest power level of the table are raised to it.
     void setAverageSpeed(uint8_t speed);
 
     uint8_t getSpeedA() const;      // left wheel
     uint8_t getSpeedB() const;      // right wheel
 
+    /// @brief Adds an observation of the wheels while driving straight at a steady speed. Once enough wheel ticks have
+    /// been observed, the ratio that would have made the wheels turn at the same speed is worked out, and the table
+    /// entries around the observed power level are moved a bounded step towards it.
+    /// @param left_power The left motor power over the observation.
+    /// @param right_power The right motor power over the observation.
+    /// @param left_ticks The left wheel ticks over the observation.
+    /// @param right_ticks The right wheel ticks over the observation.
+    void learnRatio(uint8_t left_power, uint8_t right_power, uint32_t left_ticks, uint32_t right_ticks);
+
+    /// @brief Discards the observations that have not been learned from yet, at the start of a move.
+    void clearObservations();
+
+    /// @brief Provides the left/right ratio of a table entry.
+    float getRatio(int index) const                     { return _lrRatios[index]; }
+
+    /// @brief Has the table been learned from since it was last loaded or saved?
+    bool ratiosChanged() const                          { return _lrRatiosChanged; }
+
+    /// @brief Loads the table from the EEPROM. The table is unchanged if no valid table has been saved.
+    /// @param address The EEPROM address of the table.
+    /// @return true if the table was loaded.
+    bool loadRatios(int address);
+
+    /// @brief Saves the table to the EEPROM.
+    /// @param address The EEPROM address of the table.
+    void saveRatios(int address);
+
 };
 
 #endif // __SPEEDMODEL_H__
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef __TURNMODEL_H__
+#define __TURNMODEL_H__
+#include <Arduino.h>
+
+/// @brief Plans the motor power of an in-place turn. The power is high while the turn is far from its target and
+/// tapers off in proportion to the angle that remains, down to the lowest power that still turns the robot.
+///
+/// Once the power is cut the robot coasts on, further the faster it was turning. The coast angle is modelled as
+/// `coast_factor*rate^2`, as the robot's rotational energy is spent against a roughly constant friction, and the power
+/// is cut when the angle that remains is the coast angle. The coast factor depends on the floor and the battery, so it
+/// is learned from the coast of each turn, and can be saved to and loaded from the EEPROM.
+class TurnModel {
+private:
+    uint8_t _minPower;
+    uint8_t _maxPower;
+    float _powerPerDegree;
+    float _coastFactor;
+    float _learningRate;
+    bool _changed;
+
+public:
+    /// @brief Constructs a turn model.
+    /// @param min_power The lowest power that turns the robot.
+    /// @param max_power The highest power to turn with.
+    /// @param power_per_degree The power added per degree that remains before the power is cut.
+    /// @param coast_factor The initial coast factor, in degrees per (degree/s)^2.
+    /// @param learning_rate The fraction of the difference to the observed coast factor learned from each turn.
+    TurnModel(uint8_t min_power, uint8_t max_power, float power_per_degree, float coast_factor, float learning_rate);
+    virtual ~TurnModel();
+
+    /// @brief Provides the angle the robot coasts after the power is cut.
+    /// @param rate The turn rate in degrees/s.
+    float coastAngle(float rate) const                  { return _coastFactor*rate*rate; }
+
+    /// @brief Provides the angle that remains before the power should be cut. The power is cut once it is zero or
+    /// less.
+    /// @param remaining The angle that remains to the target in degrees, positive while short of it.
+    /// @param rate The turn rate in degrees/s.
+    float cutoffAngle(float remaining, float rate) const { return remaining - coastAngle(rate); }
+
+    /// @brief Provides the power for an angle that remains before the power is cut.
+    /// @param cutoff_angle The angle from `cutoffAngle()` in degrees.
+    uint8_t power(float cutoff_angle) const;
+
+    /// @brief Learns from the coast of a turn.
+    /// @param rate The turn rate when the power was cut in degrees/s.
+    /// @param coast_angle The angle turned from when the power was cut until the robot stopped, in degrees.
+    void learn(float rate, float coast_angle);
+
+    /// @brief Provides the coast factor in degrees per (degree/s)^2.
+    float getCoastFactor() const                        { return _coastFactor; }
+
+    /// @brief Has the model been learned from since it was last loaded or saved?
+    bool changed() const                                { return _changed; }
+
+    /// @brief Loads the coast factor from the EEPROM. It is unchanged if no valid one has been saved.
+    /// @param address The EEPROM address of the model.
+    /// @return true if the coast factor was loaded.
+    bool load(int address);
+
+    /// @brief Saves the coast factor to the EEPROM.
+    /// @param address The EEPROM address of the model.
+    void save(int address);
+};
+
+#endif // __TURNMODEL_H__
@@ -0,0 +1,63 @@
+#ifndef __WHEELENCODER_H__
+#define __WHEELENCODER_H__
+#include <Arduino.h>
+
+// The number of edge timestamps kept per wheel. Must be a power of two.
+#define WHEEL_ENCODER_EDGE_BUFFER_SIZE 8
+// A wheel whose edge period would be longer than this is considered stopped.
+#define WHEEL_ENCODER_STALL_MICROS 500000UL
+
+/// @brief Counts the edges of a wheel's slotted encoder disc and keeps the `micros()` timestamps of the most recent
+/// edges, from which the wheel speed is calculated at every edge rather than over a fixed time window.
+///
+/// The edge interrupt is the only writer. It stores the timestamp into a small ring and then advances the head index,
+/// which is a single byte and so is written atomically. The foreground reads without disabling interrupts: it copies
+/// the head, reads the entries it needs and checks that the head did not move in the meantime, retrying if it did.
+///
+/// The disc has a single sensor, so the encoder can not tell the direction of rotation and the speeds are magnitudes.
+class WheelEncoder {
+private:
+    double _mmPerEdge;
+
+    // written by the interrupt
+    volatile uint32_t _count;
+    volatile uint32_t _edgeMicros[WHEEL_ENCODER_EDGE_BUFFER_SIZE];
+    volatile uint8_t _head;         // index of the next entry to be written, wraps at 256
+
+    /// @brief Copies the latest edge timestamps, newest first.
+    /// @return The number of timestamps copied, which is less than `max_edges` until enough edges have been seen.
+    uint8_t latest_edges(uint32_t* edges, uint8_t max_edges) const;
+
+    /// @brief Converts an edge period to a speed, treating a period that is still growing (no edge for longer than the
+    /// last period) as the current period, so the speed falls to zero when the wheel stops instead of holding.
+    double period_to_speed(uint32_t period_micros, uint32_t since_last_edge_micros) const;
+
+public:
+    /// @brief Constructs an encoder.
+    /// @param mm_per_edge The distance the wheel travels between two edges, in millimeters.
+    WheelEncoder(double mm_per_edge);
+    virtual ~WheelEncoder()                             { }
+
+    /// @brief Records an edge. Called from the encoder interrupt.
+    /// @param edge_micros The `micros()` time of the edge.
+    void record_edge(uint32_t edge_micros);
+
+    /// @brief Provides the number of edges since the last reset.
+    uint32_t count() const;
+
+    /// @brief Resets the edge count and forgets the edge timestamps.
+    void reset();
+
+    /// @brief Provides the speed from the period between the last two edges, in mm/s.
+    /// @param now_micros The current `micros()` time.
+    double speed(uint32_t now_micros) const;
+    double speed() const                                { return speed(micros()); }
+
+    /// @brief Provides the speed averaged over the last `WHEEL_ENCODER_EDGE_BUFFER_SIZE` edges, in mm/s. This averages
+    /// out the unevenness of the slots in the disc at the cost of some lag.
+    /// @param now_micros The current `micros()` time.
+    double filtered_speed(uint32_t now_micros) const;
+    double filtered_speed() const                       { return filtered_speed(micros()); }
+};
+
+#endif // __WHEELENCODER_H__
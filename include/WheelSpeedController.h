@@ -0,0 +1,56 @@
+#ifndef __WHEELSPEEDCONTROLLER_H__
+#define __WHEELSPEEDCONTROLLER_H__
+#include <Arduino.h>
+#include "PIDController.h"
+
+/// @brief Holds one wheel at a commanded speed in mm/s. The motor power is a feedforward estimate of the power needed
+/// for the commanded speed, plus the output of a PI controller on the encoder measured speed. The feedforward gets the
+/// power close straight away, and the PI controller removes what the estimate gets wrong, such as motor mismatch and
+/// a dropping battery voltage.
+///
+/// The feedforward is a straight line from the power at which the wheel starts turning to a reference power whose
+/// speed is known, and is typically set from the `SpeedModel`.
+class WheelSpeedController {
+private:
+    PIDController _controller;
+    uint8_t _stallPower;
+    uint8_t _referencePower;
+    double _referenceSpeed;
+    double _targetSpeed;
+    uint8_t _power;
+
+public:
+    /// @brief Constructs a wheel speed controller.
+    /// @param kp The proportional gain, in power per mm/s of speed error.
+    /// @param ki The integral gain, in power per mm of accumulated speed error.
+    /// @param max_correction The largest power the PI controller adds to or removes from the feedforward power.
+    WheelSpeedController(double kp, double ki, double max_correction);
+    virtual ~WheelSpeedController();
+
+    /// @brief Sets the feedforward model.
+    /// @param stall_power The power below which the wheel does not turn.
+    /// @param reference_power A power whose wheel speed is known.
+    /// @param reference_speed The wheel speed at `reference_power`, in mm/s.
+    void setFeedforward(uint8_t stall_power, uint8_t reference_power, double reference_speed);
+
+    /// @brief Sets the commanded wheel speed in mm/s. A speed of zero or less turns the motor power off.
+    void setTargetSpeed(double speed);
+    double getTargetSpeed() const                       { return _targetSpeed; }
+
+    /// @brief Provides the feedforward power for a wheel speed.
+    uint8_t feedforward(double speed) const;
+
+    /// @brief Updates the motor power from a speed measurement.
+    /// @param measured_speed The measured wheel speed in mm/s.
+    /// @param measurement_millis The time of the measurement in milliseconds.
+    /// @return The motor power to apply.
+    uint8_t update(double measured_speed, unsigned long measurement_millis);
+
+    /// @brief Provides the motor power from the last update.
+    uint8_t getPower() const                            { return _power; }
+
+    /// @brief Resets the PI controller, for the start of a new motion.
+    void reset();
+};
+
+#endif // __WHEELSPEEDCONTROLLER_H__
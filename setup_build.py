@@ -1,7 +1,12 @@
+import os
 import subprocess
+import sys
 
 Import("env")
 
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))
+import log_events
+
 def get_firmware_specifier_build_flag():
     ret = subprocess.run(["git", "describe", "--always", "--tags"], stdout=subprocess.PIPE, text=True) #Uses only annotated tags
     #ret = subprocess.run(["git", "describe", "--tags"], stdout=subprocess.PIPE, text=True) #Uses any tags
@@ -10,9 +15,24 @@ def get_firmware_specifier_build_flag():
     print ("Firmware Revision: " + build_version)
     return (build_flag)
 
+def generate_log_event_dictionary():
+    build_dir = env.subst("$BUILD_DIR")
+    if not os.path.isdir(build_dir):
+        os.makedirs(build_dir)
+    dictionary_path = os.path.join(build_dir, "log_events.json")
+    try:
+        dictionary = log_events.build_dictionary(env.subst("$PROJECT_DIR"))
+    except log_events.EventDictionaryError as err:
+        print("Log event dictionary error: " + str(err))
+        env.Exit(1)
+    log_events.write_dictionary(dictionary, dictionary_path)
+    print("Log event dictionary: " + dictionary_path)
+
 env.Append(
     BUILD_FLAGS=[get_firmware_specifier_build_flag()]
 )
 
+generate_log_event_dictionary()
+
 if "test" in env["BUILD_TYPE"]:
     env.Append(CPPDEFINES=["UNITY_INCLUDE_DOUBLE"])
\ No newline at end of file
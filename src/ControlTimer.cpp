@@ -0,0 +1,139 @@
+#include <util/atomic.h>
+#include "ControlTimer.h"
+#include "DataLogger.h"
+
+ControlTimer* ControlTimer::instance = nullptr;
+
+ISR(TIMER1_COMPA_vect) {
+    if (ControlTimer::instance != nullptr) {
+        ControlTimer::instance->handleISR();
+    }
+}
+
+ControlTimer::ControlTimer()
+    :   _sampler(nullptr),
+        _periodMicros(0),
+        _running(false),
+        _latest(),
+        _maxJitterMicros(0),
+        _lastTakenCount(0),
+        _overruns(0),
+        _maxLatencyMicros(0)
+{
+    if (instance == nullptr) {
+        instance = this;
+    } else {
+        ERROR_LOG("ControlTimer::ControlTimer: instance already exists");
+    }
+}
+
+ControlTimer::~ControlTimer() {
+    stop();
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+void ControlTimer::handleISR() {
+    uint32_t now = micros();
+    if (_latest.count > 0) {
+        uint32_t interval = now - _latest.micros;
+        uint32_t jitter = (interval > _periodMicros) ? interval - _periodMicros : _periodMicros - interval;
+        if (jitter > _maxJitterMicros) {
+            _maxJitterMicros = jitter;
+        }
+    }
+    _latest.count++;
+    _latest.micros = now;
+    if (_sampler != nullptr) {
+        _sampler(_latest);
+    }
+}
+
+void ControlTimer::start(uint32_t period_micros, Sampler sampler) {
+    stop();
+    reset(period_micros, sampler);
+    uint32_t counts = _periodMicros/CONTROL_TIMER_MICROS_PER_COUNT;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // CTC mode with OCR1A as TOP, prescaler 64
+        TCCR1A = 0;
+        TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+        TCNT1 = 0;
+        OCR1A = counts - 1;
+        TIMSK1 |= (1 << OCIE1A);
+    }
+    _running = true;
+}
+
+void ControlTimer::reset(uint32_t period_micros, Sampler sampler) {
+    uint32_t counts = period_micros/CONTROL_TIMER_MICROS_PER_COUNT;
+    if (counts < 1) {
+        counts = 1;
+    } else if (counts > 65536UL) {
+        counts = 65536UL;
+    }
+    _periodMicros = counts*CONTROL_TIMER_MICROS_PER_COUNT;
+    _sampler = sampler;
+    _latest.count = 0;
+    _latest.micros = 0;
+    _latest.left_wheel_counter = 0;
+    _latest.right_wheel_counter = 0;
+    _maxJitterMicros = 0;
+    _lastTakenCount = 0;
+    _overruns = 0;
+    _maxLatencyMicros = 0;
+}
+
+void ControlTimer::stop() {
+    if (!_running) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        TIMSK1 &= ~(1 << OCIE1A);
+        TCCR1B = 0;
+    }
+    _running = false;
+}
+
+bool ControlTimer::take_tick(ControlTick& tick) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        tick = _latest;
+    }
+    if (tick.count == _lastTakenCount) {
+        return false;
+    }
+    _overruns += tick.count - _lastTakenCount - 1;
+    _lastTakenCount = tick.count;
+
+    uint32_t latency = micros() - tick.micros;
+    if (latency > _maxLatencyMicros) {
+        _maxLatencyMicros = latency;
+    }
+    return true;
+}
+
+uint32_t ControlTimer::micros_to_next_tick(const ControlTick& tick) const {
+    uint32_t elapsed = micros() - tick.micros;
+    return elapsed >= _periodMicros ? 0 : _periodMicros - elapsed;
+}
+
+uint32_t ControlTimer::max_jitter_micros() const {
+    uint32_t value = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = _maxJitterMicros;
+    }
+    return value;
+}
+
+void ControlTimer::log_statistics() {
+    DEBUG_EVENT(
+        EVENT_CONTROL_TIMER_STATISTICS,
+        "ControlTimer: %lu ticks of %lu us, overruns = %lu, max jitter = %lu us, max latency = %lu us",
+        _lastTakenCount,
+        _periodMicros,
+        _overruns,
+        max_jitter_micros(),
+        _maxLatencyMicros
+    );
+}
@@ -9,6 +9,9 @@ const int SD_SCLK_PIN = 52;
 const int SD_DO_PIN = 50;
 const int SD_DI_PIN = 51;
 
+// how often the buffered log file is synced to the SD card even if a full sector has not been collected
+const unsigned long LOG_SYNC_INTERVAL_MILLIS = 2000;
+
 
 DataLogger* DataLogger::_instance = nullptr;
 
@@ -18,8 +21,19 @@ const String INFO_PREFIX = "INFO: ";
 const String WARNING_PREFIX = "WARNING: ";
 const String ERROR_PREFIX = "ERROR: ";
 
-DataLogger::DataLogger(LogType log_level)
-    :   _logLevel(log_level)
+DataLogger::DataLogger(LogType log_level, bool buffered)
+    :   _logLevel(log_level),
+        _buffered(buffered),
+        _logFile(),
+        _logBuffer(),
+        _serialBuffer(),
+        _lastSyncMillis(millis()),
+        _logFileDirty(false),
+        _maxWriteMicros(0),
+        _droppedRecords(0),
+        _droppedBytes(0),
+        _tableFormat(CSV_TABLE),
+        _tableSequenceNumber(0)
 {
     if (_instance == nullptr) {
         _instance = this;
@@ -65,8 +79,7 @@ DataLogger::DataLogger(LogType log_level)
         String sequenceNumberString = sequenceNumberFile.readStringUntil('\n');
         sequenceNumberFile.close();
         _logSequenceNumber = sequenceNumberString.toInt();
-        sprintf_P(_buffer, PSTR("DataLogger: initial sequence number is %d, incrementing it"), _logSequenceNumber);
-        INFO_LOG(_buffer);
+        INFO_LOGF("DataLogger: initial sequence number is %d, incrementing it", _logSequenceNumber);
         _logSequenceNumber++;
         // roll over if we hit 1000
         if (_logSequenceNumber > 999) {
@@ -93,6 +106,10 @@ DataLogger::DataLogger(LogType log_level)
     File logFile = SD.open(_logFileName, FILE_WRITE);
     if (!logFile) {
         ERROR_LOG(F("DataLogger: could not create log file"));
+    } else if (_buffered) {
+        // keep the log file open for the life of the logger
+        _logFile = logFile;
+        DEBUG_LOG(F("DataLogger: log file created, buffered mode"));
     } else {
         logFile.close();
         DEBUG_LOG(F("DataLogger: log file created"));
@@ -100,11 +117,89 @@ DataLogger::DataLogger(LogType log_level)
 }
 
 DataLogger::~DataLogger() {
-    // TODO Auto-generated destructor stub
+    if (_logFile) {
+        sync();
+        _logFile.close();
+    }
+}
+
+void DataLogger::loop(bool idle) {
+    write_serial_buffer(min(Serial.availableForWrite(), LOG_SERIAL_DRAIN_BYTES));
+    if (!_logFile) {
+        return;
+    }
+    if (_logBuffer.size() >= LOG_SECTOR_SIZE) {
+        write_log_buffer(LOG_SECTOR_SIZE);
+    } else if (idle && millis() - _lastSyncMillis > LOG_SYNC_INTERVAL_MILLIS) {
+        // less than a sector is queued, so this writes it all
+        write_log_buffer(LOG_SECTOR_SIZE);
+        if (_logFileDirty) {
+            flush_log_file();
+        }
+        _lastSyncMillis = millis();
+    }
+}
+
+void DataLogger::sync() {
+    write_serial_buffer(LOG_SERIAL_BUFFER_SIZE);
+    if (!_logFile) {
+        return;
+    }
+    while (!_logBuffer.is_empty()) {
+        write_log_buffer(LOG_SECTOR_SIZE);
+    }
+    flush_log_file();
+    _lastSyncMillis = millis();
 }
 
-void DataLogger::loop() {
+void DataLogger::flush_log_file() {
+    unsigned long startMicros = micros();
+    _logFile.flush();
+    _logFileDirty = false;
+    unsigned long elapsed = micros() - startMicros;
+    if (elapsed > _maxWriteMicros) {
+        _maxWriteMicros = elapsed;
+    }
+}
 
+// writes up to max_bytes of buffered log data to the log file. The SD library caches a single sector, so
+// writing a sector's worth of data at a time results in whole sector writes.
+void DataLogger::write_log_buffer(uint16_t max_bytes) {
+    if (_logBuffer.is_empty()) {
+        return;
+    }
+    _logFileDirty = true;
+    unsigned long startMicros = micros();
+    while (max_bytes > 0 && !_logBuffer.is_empty()) {
+        uint16_t chunk = min(_logBuffer.contiguous_size(), max_bytes);
+        _logFile.write(_logBuffer.read_pointer(), chunk);
+        _logBuffer.consume(chunk);
+        max_bytes -= chunk;
+    }
+    unsigned long elapsed = micros() - startMicros;
+    if (elapsed > _maxWriteMicros) {
+        _maxWriteMicros = elapsed;
+    }
+}
+
+// sends up to max_bytes of queued log data to Serial. Serial.write() blocks if more is written than fits into the
+// serial transmit buffer, so loop() limits max_bytes to Serial.availableForWrite().
+void DataLogger::write_serial_buffer(uint16_t max_bytes) {
+    while (max_bytes > 0 && !_serialBuffer.is_empty()) {
+        uint16_t chunk = min(_serialBuffer.contiguous_size(), max_bytes);
+        Serial.write(_serialBuffer.read_pointer(), chunk);
+        _serialBuffer.consume(chunk);
+        max_bytes -= chunk;
+    }
+}
+
+void DataLogger::log_statistics() {
+    INFO_LOGF(
+        "DataLogger: dropped records = %lu, dropped bytes = %lu, max write latency = %lu usecs",
+        dropped_records(),
+        dropped_bytes(),
+        max_write_micros()
+    );
 }
 
 const String& DataLogger::get_log_prefix(LogType logType) const {
@@ -123,32 +218,78 @@ const String& DataLogger::get_log_prefix(LogType logType) const {
     }
 }
 
-void DataLogger::log(LogType logType, const String& message) {
-    if (logType < _logLevel && logType != NONE) {
+static uint16_t log_message_length(const char* message) {
+    return strlen(message);
+}
+
+static uint16_t log_message_length(const __FlashStringHelper* message) {
+    return strlen_P(reinterpret_cast<PGM_P>(message));
+}
+
+static uint16_t log_message_length(const String& message) {
+    return message.length();
+}
+
+// queues a whole log record, or drops and counts it if it does not fit into the queue
+template <typename B, typename M>
+void DataLogger::enqueue_log_record(B& buffer, const String& prefix, const M& message, uint16_t length) {
+    if (buffer.free_space() < length) {
+        _droppedRecords++;
+        _droppedBytes += length;
         return;
     }
-    const String& prefix = get_log_prefix(logType);
-    Serial.print(prefix);
-    Serial.println(message);
+    buffer.print(prefix);
+    buffer.println(message);
+}
+
+// queues a whole binary record, or drops and counts it if it does not fit into the queue
+template <typename B>
+void DataLogger::enqueue_log_bytes(B& buffer, const uint8_t* data, uint16_t length) {
+    if (buffer.free_space() < length) {
+        _droppedRecords++;
+        _droppedBytes += length;
+        return;
+    }
+    buffer.write(data, length);
+}
+
+void DataLogger::write_event_record(const LogEventRecord& record) {
+    if (_buffered) {
+        enqueue_log_bytes(_serialBuffer, record.data(), record.size());
+        if (_logFile) {
+            enqueue_log_bytes(_logBuffer, record.data(), record.size());
+        }
+        return;
+    }
+    Serial.write(record.data(), record.size());
     if (_logFileName[0] != '\0') {
         File logFile = SD.open(_logFileName, FILE_WRITE);
-        if ((bool)logFile) {
-            logFile.print(prefix);
-            logFile.println(message);
+        if (logFile) {
+            logFile.write(record.data(), record.size());
             logFile.flush();
             logFile.close();
         } else {
-            Serial.print(F("DataLogger::log: could not open log file for writing: "));
+            Serial.print(F("DataLogger::log_event: could not open log file for writing: "));
             Serial.println(_logFileName);
         }
     }
 }
 
-void DataLogger::log(LogType logType, const char* message) {
+template <typename M>
+void DataLogger::write_log_message(LogType logType, const M& message) {
     if (logType < _logLevel && logType != NONE) {
         return;
     }
     const String& prefix = get_log_prefix(logType);
+    if (_buffered) {
+        // record length includes the line ending added by println()
+        uint16_t length = prefix.length() + log_message_length(message) + 2;
+        enqueue_log_record(_serialBuffer, prefix, message, length);
+        if (_logFile) {
+            enqueue_log_record(_logBuffer, prefix, message, length);
+        }
+        return;
+    }
     Serial.print(prefix);
     Serial.println(message);
     if (_logFileName[0] != '\0') {
@@ -165,34 +306,95 @@ void DataLogger::log(LogType logType, const char* message) {
     }
 }
 
+void DataLogger::log(LogType logType, const String& message) {
+    write_log_message(logType, message);
+}
+
+void DataLogger::log(LogType logType, const char* message) {
+    write_log_message(logType, message);
+}
+
 void DataLogger::log(LogType logType, const __FlashStringHelper* message) {
-   if (logType < _logLevel && logType != NONE) {
+    write_log_message(logType, message);
+}
+
+// reports how much memory a table took so tables can be sized for long runs
+template <typename T>
+void DataLogger::log_table_usage(const DataTable<T>& dataTable) {
+    DEBUG_EVENT(
+        EVENT_DATA_TABLE_USAGE,
+        "DataLogger::log_data_table: %d rows, %u of %u bytes used, high water mark = %u bytes, dropped rows = %lu",
+        dataTable.num_rows(),
+        dataTable.bytes_used(),
+        dataTable.bytes_allocated(),
+        dataTable.high_water_mark(),
+        dataTable.dropped_rows()
+    );
+}
+
+// the column formats that compressed binary tables are quantized to. A FieldFormatter has none
+static const DataColumnFormat* binary_table_formats(const DataColumnFormat* formats) {
+    return formats;
+}
+
+template <typename F>
+static const DataColumnFormat* binary_table_formats(F formatter) {
+    return nullptr;
+}
+
+template <typename T>
+void DataLogger::write_binary_table(const DataTable<T>& dataTable, const DataColumnFormat* formats) {
+    sync();
+    if (_logFileName[0] == '\0') {
+        // no SD card, so send the table over Serial, in frames so that it can be told apart from the event records.
+        // The capture can be decoded with tools/dtb_to_csv.py
+        LogFrameStream frames(Serial);
+        dataTable.write_binary_to_stream(frames, _tableFormat == COMPRESSED_TABLE, formats);
+        frames.finish();
+        Serial.println();
         return;
     }
-    const String& prefix = get_log_prefix(logType);
-    Serial.print(prefix);
-    Serial.println(message);
-    if (_logFileName[0] != '\0') {
-        File logFile = SD.open(_logFileName, FILE_WRITE);
-        if (logFile) {
-            logFile.print(prefix);
-            logFile.println(message);
-            logFile.flush();
-            logFile.close();
-        } else {
-            Serial.print(F("DataLogger::log: could not open log file for writing: "));
-            Serial.println(_logFileName);
-        }
+    char tableFileName[20];
+    sprintf_P(tableFileName, PSTR("log/t%03d%03d.dtb"), _logSequenceNumber, _tableSequenceNumber);
+    _tableSequenceNumber = (_tableSequenceNumber + 1) % 1000;
+    if (SD.exists(tableFileName)) {
+        SD.remove(tableFileName);
+    }
+    File tableFile = SD.open(tableFileName, FILE_WRITE);
+    if (!tableFile) {
+        Serial.print(F("DataLogger::log_data_table: could not open table file for writing: "));
+        Serial.println(tableFileName);
+        return;
     }
+    dataTable.write_binary_to_stream(tableFile, _tableFormat == COMPRESSED_TABLE, formats);
+    tableFile.close();
+
+    INFO_LOGF(
+        "DataLogger: wrote data table with %d rows to %s",
+        dataTable.num_rows(),
+        tableFileName
+    );
 }
 
-void DataLogger::log_data_table(const DataTable<double>& dataTable, DataTable<double>::FieldFormatter formatter) {
-    dataTable.write_to_stream(Serial, formatter);
+// the format is either a FieldFormatter or an array of DataColumnFormat, and is passed on to DataTable::write_to_stream()
+template <typename T, typename F>
+void DataLogger::write_table(const DataTable<T>& dataTable, F format) {
+    log_table_usage(dataTable);
+    if (_tableFormat != CSV_TABLE) {
+        write_binary_table(dataTable, binary_table_formats(format));
+        return;
+    }
+    // keep the table in order with the queued messages that preceded it
+    sync();
+    dataTable.write_to_stream(Serial, format);
 
-    if (_logFileName[0] != '\0') {
+    if (_logFile) {
+        dataTable.write_to_stream(_logFile, format);
+        _logFile.flush();
+    } else if (_logFileName[0] != '\0') {
         File logFile = SD.open(_logFileName, FILE_WRITE);
         if (logFile) {
-            dataTable.write_to_stream(logFile, formatter);
+            dataTable.write_to_stream(logFile, format);
             logFile.flush();
             logFile.close();
         } else {
@@ -202,18 +404,18 @@ void DataLogger::log_data_table(const DataTable<double>& dataTable, DataTable<do
     }
 }
 
+void DataLogger::log_data_table(const DataTable<double>& dataTable, DataTable<double>::FieldFormatter formatter) {
+    write_table(dataTable, formatter);
+}
+
 void DataLogger::log_data_table(const DataTable<int>& dataTable, DataTable<int>::FieldFormatter formatter) {
-    dataTable.write_to_stream(Serial, formatter);
+    write_table(dataTable, formatter);
+}
 
-    if (_logFileName[0] != '\0') {
-        File logFile = SD.open(_logFileName, FILE_WRITE);
-        if (logFile) {
-            dataTable.write_to_stream(logFile, formatter);
-            logFile.flush();
-            logFile.close();
-        } else {
-            Serial.print(F("DataLogger::log_data_table: could not open log file for writing: "));
-            Serial.println(_logFileName);
-        }
-    }
+void DataLogger::log_data_table(const DataTable<double>& dataTable, const DataColumnFormat* formats) {
+    write_table(dataTable, formats);
+}
+
+void DataLogger::log_data_table(const DataTable<int>& dataTable, const DataColumnFormat* formats) {
+    write_table(dataTable, formats);
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "DataTable.h"
+
+uint8_t format_data_unsigned(char* buffer, uint32_t value) {
+    // write the digits backwards from the end of the buffer, then move them to the front
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (uint8_t i = 0; i < count; i++) {
+        buffer[i] = digits[count - 1 - i];
+    }
+    buffer[count] = '\0';
+    return count;
+}
+
+uint8_t format_data_integer(char* buffer, int32_t value) {
+    if (value < 0) {
+        buffer[0] = '-';
+        // negate as unsigned so the most negative value does not overflow
+        return 1 + format_data_unsigned(buffer + 1, 0u - (uint32_t)value);
+    }
+    return format_data_unsigned(buffer, value);
+}
+
+uint8_t format_data_fixed(char* buffer, double value, uint8_t decimals) {
+    if (isnan(value)) {
+        strcpy(buffer, "nan");
+        return 3;
+    }
+    if (isinf(value)) {
+        strcpy(buffer, "inf");
+        return 3;
+    }
+    // the same limit as Print::printFloat, beyond which the integer part does not fit in 32 bits
+    if (value > 4294967040.0 || value < -4294967040.0) {
+        strcpy(buffer, "ovf");
+        return 3;
+    }
+    if (decimals > DATA_FORMAT_MAX_DECIMALS) {
+        decimals = DATA_FORMAT_MAX_DECIMALS;
+    }
+
+    uint8_t length = 0;
+    if (value < 0.0) {
+        buffer[length++] = '-';
+        value = -value;
+    }
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < decimals; i++) {
+        rounding /= 10.0;
+    }
+    value += rounding;
+
+    uint32_t integer_part = (uint32_t)value;
+    double remainder = value - (double)integer_part;
+    length += format_data_unsigned(buffer + length, integer_part);
+    if (decimals > 0) {
+        buffer[length++] = '.';
+        while (decimals-- > 0) {
+            remainder *= 10.0;
+            uint8_t digit = (uint8_t)remainder;
+            buffer[length++] = '0' + digit;
+            remainder -= digit;
+        }
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+int32_t quantize_data_value(double value, uint8_t decimals) {
+    double scaled = value;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scaled *= 10.0;
+    }
+    // rounding half away from zero, as the CSV formatting does
+    scaled = (scaled < 0) ? scaled - 0.5 : scaled + 0.5;
+    // also true for nan. The bounds are exact as floats, so they hold on the AVR, where a double is a float
+    if (!(scaled > -2147483648.0 && scaled < 2147483648.0)) {
+        return DATA_TABLE_QUANTIZED_INVALID;
+    }
+    return (int32_t)scaled;
+}
+
+uint8_t encode_varint(uint8_t* buffer, uint32_t value) {
+    uint8_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    return length;
+}
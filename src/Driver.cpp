@@ -2,9 +2,18 @@
 #include "Driver.h"
 #include "DataLogger.h"
 
+const double FOLLOW_MAX_START_BEARING = 45.0;      // degrees, a larger bearing to the first point is turned in place
+
 Driver::Driver()
-    :   _isDriving(false),
-        _robot()
+    :   _state(DRIVER_IDLE),
+        _path(),
+        _segment(0),
+        _currentPoint(),
+        _currentBearing(0),
+        _segmentBearing(0),
+        _segmentDistance(0),
+        _robot(),
+        _commandLength(0)
 {
 
 }
@@ -15,77 +24,267 @@ Driver::~Driver() {
 
 void Driver::loop() {
     _robot.loop();
-    if (_isDriving) {
-        INFO_LOG(F("Driver::loop: driving"));
-        _robot.statusLEDBlinkFast();
-        PointSequence path;
-        path.add(Point(0, 0));
-        path.add(Point(0, 1500));
-        path.add(Point(-250, 1500));
-        path.add(Point(-250, 1000));
-        path.add(Point(0, 1000));
-        path.add(Point(0, 0));
-        trace_path(path);
-        _robot.statusLEDBlinkSlow();
-        INFO_LOG(F("Driver::loop: driving done"));
-        _isDriving = false;
+    switch (_state) {
+        case DRIVER_TURNING:
+            if (!_robot.is_in_motion()) {
+                start_segment_move(_robot.turn_result());
+            }
+            break;
+        case DRIVER_MOVING:
+            if (!_robot.is_in_motion()) {
+                finish_segment(_robot.move_result());
+            }
+            break;
+        case DRIVER_FOLLOW_TURNING:
+            if (!_robot.is_in_motion()) {
+                if (_robot.start_follow(_path)) {
+                    _state = DRIVER_FOLLOWING;
+                } else {
+                    finish_path();
+                }
+            }
+            break;
+        case DRIVER_FOLLOWING:
+            if (!_robot.is_in_motion()) {
+                finish_path();
+            }
+            break;
+        case DRIVER_AUTOTUNING:
+            if (!_robot.is_in_motion()) {
+                _state = DRIVER_IDLE;
+                _robot.statusLEDBlinkSlow();
+                INFO_LOG(F("Driver::loop: autotune done"));
+            }
+            break;
+        case DRIVER_IDLE:
+        default:
+            break;
     }
-    else if (_robot.buttonPressed()) {
-        INFO_LOG(F("Driver::loop: button pressed"));
-        _isDriving = true;
+
+    handle_button();
+    read_commands();
+}
+
+void Driver::handle_button() {
+    switch (_robot.buttonEvent()) {
+        case BUTTON_SHORT_PRESS:
+            if (is_driving()) {
+                INFO_LOG(F("Driver::loop: button pressed, cancelling"));
+                cancel();
+            } else {
+                INFO_LOG(F("Driver::loop: button pressed"));
+                start_demo_path(true);
+            }
+            break;
+        case BUTTON_LONG_PRESS:
+            INFO_LOG(F("Driver::loop: button long pressed"));
+            start_autotune();
+            break;
+        case BUTTON_NONE:
+        default:
+            break;
     }
 }
 
-void Driver::trace_path(const PointSequence& path) {
+void Driver::read_commands() {
+    while (Serial.available() > 0) {
+        char c = Serial.read();
+        if (c == '\n' || c == '\r') {
+            if (_commandLength > 0) {
+                _command[_commandLength] = '\0';
+                run_command(_command);
+                _commandLength = 0;
+            }
+        } else if (_commandLength < DRIVER_COMMAND_SIZE - 1) {
+            _command[_commandLength++] = c;
+        }
+    }
+}
+
+void Driver::run_command(const char* command) {
+    if (strcmp(command, "drive") == 0) {
+        start_demo_path(false);
+    } else if (strcmp(command, "follow") == 0) {
+        start_demo_path(true);
+    } else if (strcmp(command, "cancel") == 0) {
+        cancel();
+    } else if (strcmp(command, "autotune") == 0) {
+        start_autotune();
+    } else if (strcmp(command, "gains") == 0) {
+        _robot.log_heading_gains();
+    } else if (strcmp(command, "csv") == 0) {
+        DataLogger::getInstance()->set_table_format(DataLogger::CSV_TABLE);
+    } else if (strcmp(command, "binary") == 0) {
+        DataLogger::getInstance()->set_table_format(DataLogger::BINARY_TABLE);
+    } else if (strcmp(command, "compressed") == 0) {
+        DataLogger::getInstance()->set_table_format(DataLogger::COMPRESSED_TABLE);
+    } else {
+        WARNING_LOGF("Driver::run_command: unknown command '%s'", command);
+    }
+}
+
+bool Driver::start_demo_path(bool follow) {
+    PointSequence path;
+    path.add(Point(0, 0));
+    path.add(Point(0, 1500));
+    path.add(Point(-250, 1500));
+    path.add(Point(-250, 1000));
+    path.add(Point(0, 1000));
+    path.add(Point(0, 0));
+    if (follow ? !start_follow(path) : !start_path(path)) {
+        return false;
+    }
+    INFO_LOG(F("Driver::loop: driving"));
+    _robot.statusLEDBlinkFast();
+    return true;
+}
+
+bool Driver::start_autotune() {
+    if (is_driving() || _robot.is_in_motion()) {
+        ERROR_LOG(F("Driver::start_autotune: already driving"));
+        return false;
+    }
+    if (!_robot.start_heading_autotune()) {
+        return false;
+    }
+    INFO_LOG(F("Driver::loop: autotuning"));
+    _state = DRIVER_AUTOTUNING;
+    _robot.statusLEDBlinkFast();
+    return true;
+}
+
+bool Driver::start_path(const PointSequence& path) {
+    if (is_driving() || _robot.is_in_motion()) {
+        ERROR_LOG(F("Driver::start_path: already driving"));
+        return false;
+    }
     if (path.size() <= 1) {
         ERROR_LOG(F("Driver::trace_path: path size is too small"));
+        return false;
+    }
+    set_path(path);
+    start_segment();
+    return true;
+}
+
+bool Driver::start_follow(const PointSequence& path) {
+    if (is_driving() || _robot.is_in_motion()) {
+        ERROR_LOG(F("Driver::start_follow: already driving"));
+        return false;
+    }
+    if (path.size() <= 1) {
+        ERROR_LOG(F("Driver::start_follow: path size is too small"));
+        return false;
+    }
+    set_path(path);
+
+    // the pursuit steers onto the path from small bearing errors, but would swing wide from a point behind the robot
+    double bearing = _currentPoint.absolute_bearing(_path[1]);
+    if (abs(bearing) >= FOLLOW_MAX_START_BEARING && _robot.start_turn(bearing)) {
+        _state = DRIVER_FOLLOW_TURNING;
+        return true;
+    }
+    if (!_robot.start_follow(_path)) {
+        return false;
+    }
+    _state = DRIVER_FOLLOWING;
+    return true;
+}
+
+void Driver::set_path(const PointSequence& path) {
+    _path.clear();
+    _path.add(path);
+    _currentPoint = _path[0];
+    _currentBearing = 0;
+    _robot.reset_pose(_currentPoint.x(), _currentPoint.y(), _currentBearing);
+    _segment = 1;
+}
+
+void Driver::cancel() {
+    if (!is_driving()) {
         return;
     }
-    Point current_point = path[0];
-    double current_bearing = 0;
-
-    for (uint16_t i = 1; i < path.size(); i++) {
-        Point next_point = path[i];
-
-        double distance = current_point.distance(next_point);
-        double bearing = current_point.absolute_bearing(next_point);
-        double bearing_delta = bearing - current_bearing;
-
-        sprintf_P(
-            DataLogger::commonBuffer(),
-            PSTR("Driver::trace_path: current_point=%s, next_point=%s, distance=%s, bearing=%s, bearing_delta=%s"),
-            String(current_point).c_str(),
-            String(next_point).c_str(),
-            String(distance).c_str(),
-            String(bearing).c_str(),
-            String(bearing_delta).c_str()
-        );
-        INFO_LOG(DataLogger::commonBuffer());
-
-        int turn_results = 0;
-        if (abs(bearing_delta) >= _robot.min_turn_angle()) {
-            turn_results = _robot.turn(bearing_delta);
-            delay(200);
-        }
-        sprintf_P(
-            DataLogger::commonBuffer(),
-            PSTR("Driver::trace_path: completed turn, turn_results=%d"),
-            turn_results
-        );
-        INFO_LOG(DataLogger::commonBuffer());
-
-        Point move_results;
-        if (distance >= _robot.min_move_distance()) {
-            move_results = _robot.move(distance);
-        }
-        sprintf_P(
-            DataLogger::commonBuffer(),
-            PSTR("Driver::trace_path: completed forward move, move_results=%s"),
-            String(move_results).c_str()
-        );
-        INFO_LOG(DataLogger::commonBuffer());
-        delay(200);
-        current_point = next_point;
-        current_bearing = bearing;
+    _robot.cancel_motion();
+    if (_state == DRIVER_AUTOTUNING) {
+        _state = DRIVER_IDLE;
+        _robot.statusLEDBlinkSlow();
+        return;
     }
+    // the cancelled move still brakes, so let the robot finish it in its own loop
+    finish_path();
+}
+
+void Driver::trace_path(const PointSequence& path) {
+    if (!start_path(path)) {
+        return;
+    }
+    while (is_driving()) {
+        this->loop();
+    }
+}
+
+void Driver::start_segment() {
+    Point next_point = _path[_segment];
+
+    _segmentDistance = _currentPoint.distance(next_point);
+    _segmentBearing = _currentPoint.absolute_bearing(next_point);
+    double bearing_delta = _segmentBearing - _currentBearing;
+
+    INFO_EVENT(
+        EVENT_DRIVER_SEGMENT_START,
+        "Driver::trace_path: current_point=(%d,%d), next_point=(%d,%d), distance=%.2f, bearing=%.2f, bearing_delta=%.2f",
+        _currentPoint.x(),
+        _currentPoint.y(),
+        next_point.x(),
+        next_point.y(),
+        _segmentDistance,
+        _segmentBearing,
+        bearing_delta
+    );
+
+    if (abs(bearing_delta) >= _robot.min_turn_angle() && _robot.start_turn(bearing_delta)) {
+        _state = DRIVER_TURNING;
+    } else {
+        start_segment_move(0);
+    }
+}
+
+void Driver::start_segment_move(int turn_results) {
+    INFO_EVENT(
+        EVENT_DRIVER_TURN_COMPLETE,
+        "Driver::trace_path: completed turn, turn_results=%d",
+        turn_results
+    );
+
+    if (_segmentDistance >= _robot.min_move_distance() && _robot.start_move(_segmentDistance)) {
+        _state = DRIVER_MOVING;
+    } else {
+        finish_segment(Point());
+    }
+}
+
+void Driver::finish_segment(const Point& move_results) {
+    INFO_EVENT(
+        EVENT_DRIVER_MOVE_COMPLETE,
+        "Driver::trace_path: completed forward move, move_results=(%d,%d)",
+        move_results.x(),
+        move_results.y()
+    );
+    _currentPoint = _path[_segment];
+    _currentBearing = _segmentBearing;
+    _segment++;
+    if (_segment < _path.size()) {
+        start_segment();
+    } else {
+        finish_path();
+    }
+}
+
+void Driver::finish_path() {
+    _state = DRIVER_IDLE;
+    _robot.statusLEDBlinkSlow();
+    INFO_LOG(F("Driver::loop: driving done"));
+    DEBUG_LOG(F("Driver::loop: the trajectory:"));
+    DataLogger::getInstance()->log_data_table(_robot.pose().trajectory(), PoseEstimator::TRAJECTORY_FORMATS);
+    DataLogger::getInstance()->log_statistics();
 }
\ No newline at end of file
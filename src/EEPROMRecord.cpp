@@ -0,0 +1,51 @@
+#include <EEPROM.h>
+#include "EEPROMRecord.h"
+
+static uint16_t crc16_update(uint16_t crc, uint8_t value) {
+    crc ^= (uint16_t)value << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+bool read_eeprom_record(int address, uint8_t version, void* data, uint8_t size) {
+    if (address < 0 || address + size + EEPROM_RECORD_OVERHEAD > (int)EEPROM.length()) {
+        return false;
+    }
+    if (EEPROM.read(address) != EEPROM_RECORD_MARKER
+            || EEPROM.read(address + 1) != version
+            || EEPROM.read(address + 2) != size) {
+        return false;
+    }
+    uint16_t crc = crc16_update(crc16_update(0xFFFF, version), size);
+    for (uint8_t i = 0; i < size; i++) {
+        crc = crc16_update(crc, EEPROM.read(address + 3 + i));
+    }
+    uint16_t stored_crc = EEPROM.read(address + 3 + size) | (uint16_t)EEPROM.read(address + 4 + size) << 8;
+    if (crc != stored_crc) {
+        return false;
+    }
+    uint8_t* bytes = (uint8_t*)data;
+    for (uint8_t i = 0; i < size; i++) {
+        bytes[i] = EEPROM.read(address + 3 + i);
+    }
+    return true;
+}
+
+void write_eeprom_record(int address, uint8_t version, const void* data, uint8_t size) {
+    if (address < 0 || address + size + EEPROM_RECORD_OVERHEAD > (int)EEPROM.length()) {
+        return;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint16_t crc = crc16_update(crc16_update(0xFFFF, version), size);
+    EEPROM.update(address, EEPROM_RECORD_MARKER);
+    EEPROM.update(address + 1, version);
+    EEPROM.update(address + 2, size);
+    for (uint8_t i = 0; i < size; i++) {
+        EEPROM.update(address + 3 + i, bytes[i]);
+        crc = crc16_update(crc, bytes[i]);
+    }
+    EEPROM.update(address + 3 + size, crc & 0xFF);
+    EEPROM.update(address + 4 + size, crc >> 8);
+}
@@ -0,0 +1,51 @@
+#include "FixedPoint.h"
+
+// The sine table covers a quarter wave in 128 segments. A full turn is 512 segments, so the segment of an angle is
+// angle*512/(2*pi), and the low 16 bits of that in Q16.16 are the position within the segment.
+#define SINE_TABLE_SEGMENTS 128
+const q16_t SEGMENTS_PER_RADIAN = Q16(4*SINE_TABLE_SEGMENTS/(2*PI));
+
+// sin(i*(pi/2)/128)*65536. The final entry, sin(pi/2), is 65536 which does not fit, so it is not stored.
+const uint16_t SINE_TABLE[SINE_TABLE_SEGMENTS] PROGMEM = {
+        0,   804,  1608,  2412,  3216,  4019,  4821,  5623,
+     6424,  7224,  8022,  8820,  9616, 10411, 11204, 11996,
+    12785, 13573, 14359, 15143, 15924, 16703, 17479, 18253,
+    19024, 19792, 20557, 21320, 22078, 22834, 23586, 24335,
+    25080, 25821, 26558, 27291, 28020, 28745, 29466, 30182,
+    30893, 31600, 32303, 33000, 33692, 34380, 35062, 35738,
+    36410, 37076, 37736, 38391, 39040, 39683, 40320, 40951,
+    41576, 42194, 42806, 43412, 44011, 44604, 45190, 45769,
+    46341, 46906, 47464, 48015, 48559, 49095, 49624, 50146,
+    50660, 51166, 51665, 52156, 52639, 53114, 53581, 54040,
+    54491, 54934, 55368, 55794, 56212, 56621, 57022, 57414,
+    57798, 58172, 58538, 58896, 59244, 59583, 59914, 60235,
+    60547, 60851, 61145, 61429, 61705, 61971, 62228, 62476,
+    62714, 62943, 63162, 63372, 63572, 63763, 63944, 64115,
+    64277, 64429, 64571, 64704, 64827, 64940, 65043, 65137,
+    65220, 65294, 65358, 65413, 65457, 65492, 65516, 65531
+};
+
+static uint32_t sine_table_entry(uint8_t index) {
+    return index < SINE_TABLE_SEGMENTS ? pgm_read_word(&SINE_TABLE[index]) : 65536UL;
+}
+
+q16_t q16_sin(q16_t radians) {
+    q16_t position = q16_mul(radians, SEGMENTS_PER_RADIAN);
+    uint16_t segment = (uint16_t)(position >> 16) & (4*SINE_TABLE_SEGMENTS - 1);
+    uint32_t fraction = (uint16_t)position;
+    uint8_t quadrant = segment/SINE_TABLE_SEGMENTS;
+    uint8_t index = segment % SINE_TABLE_SEGMENTS;
+
+    uint32_t from;
+    uint32_t to;
+    if (quadrant & 1) {
+        // the falling quarters run the table backwards
+        from = sine_table_entry(SINE_TABLE_SEGMENTS - index);
+        to = sine_table_entry(SINE_TABLE_SEGMENTS - index - 1);
+    } else {
+        from = sine_table_entry(index);
+        to = sine_table_entry(index + 1);
+    }
+    q16_t value = from + (q16_t)((((int32_t)to - (int32_t)from)*(int32_t)fraction + 0x8000) >> 16);
+    return (quadrant & 2) ? -value : value;
+}
@@ -17,7 +17,8 @@ const MPU6050_IMU::GYRO_FS GYRO_FULL_SCALE = MPU6050_IMU::GYRO_FS::MPU6050_GYRO_
 
 HeadingCalculator::HeadingCalculator()
     :   _mpu(),
-        _heading(0)
+        _heading(0),
+        _rate(0)
 {
     _mpu.initialize();
     _mpu.setFullScaleGyroRange(GYRO_FULL_SCALE);
@@ -57,6 +58,7 @@ float HeadingCalculator::update()
         double gyro_angle = gyro_rate * (now - _lastUpdate) / 1000.0;
 
         _heading += gyro_angle;
+        _rate = gyro_rate;
         _lastUpdate = now;
 
         if (_heading > 180) {
@@ -0,0 +1,36 @@
+#include "HeadingFilter.h"
+
+HeadingFilter::HeadingFilter(float gyro_variance_rate, float wheel_variance, float slip_variance_per_mm)
+    :   _gyroVarianceRate(gyro_variance_rate),
+        _wheelVariance(wheel_variance),
+        _slipVariancePerMM(slip_variance_per_mm),
+        _heading(0.0),
+        _variance(0.0),
+        _lastGyroHeading(0.0)
+{
+}
+
+HeadingFilter::~HeadingFilter() {
+}
+
+void HeadingFilter::reset(float heading) {
+    _heading = heading;
+    _variance = 0.0;
+    _lastGyroHeading = heading;
+}
+
+void HeadingFilter::predict(float gyro_heading, float dt) {
+    _heading += gyro_heading - _lastGyroHeading;
+    _lastGyroHeading = gyro_heading;
+    _variance += _gyroVarianceRate*dt;
+}
+
+void HeadingFilter::correct(float wheel_heading, float distance) {
+    float measurement_variance = _wheelVariance + _slipVariancePerMM*distance;
+    if (_variance + measurement_variance <= 0.0) {
+        return;
+    }
+    float gain = _variance/(_variance + measurement_variance);
+    _heading += gain*(wheel_heading - _heading);
+    _variance *= 1.0 - gain;
+}
@@ -0,0 +1,48 @@
+#include "MotionProfile.h"
+
+MotionProfile::MotionProfile(double acceleration, double cruise_speed, double deceleration, double final_speed)
+    :   _acceleration(acceleration),
+        _cruiseSpeed(cruise_speed),
+        _deceleration(deceleration),
+        _finalSpeed(final_speed),
+        _distance(0.0),
+        _speed(0.0)
+{
+}
+
+MotionProfile::~MotionProfile() {
+}
+
+void MotionProfile::start(double distance, double initial_speed) {
+    _distance = distance;
+    _speed = initial_speed;
+}
+
+double MotionProfile::stoppingSpeed(double remaining) const {
+    if (remaining <= 0.0) {
+        return _finalSpeed;
+    }
+    // v^2 = v_final^2 + 2*a*d
+    return sqrt(_finalSpeed*_finalSpeed + 2.0*_deceleration*remaining);
+}
+
+double MotionProfile::update(double travelled, double dt) {
+    double remaining = _distance - travelled;
+    if (remaining <= 0.0) {
+        _speed = 0.0;
+        return _speed;
+    }
+    double speed = _speed + _acceleration*dt;
+    if (speed > _cruiseSpeed) {
+        speed = _cruiseSpeed;
+    }
+    double stopping_speed = stoppingSpeed(remaining);
+    if (speed > stopping_speed) {
+        speed = stopping_speed;
+    }
+    if (speed < _finalSpeed) {
+        speed = _finalSpeed;
+    }
+    _speed = speed;
+    return _speed;
+}
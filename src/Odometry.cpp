@@ -0,0 +1,57 @@
+#include "Odometry.h"
+
+// Turning angle formula (in radians):
+//
+//   angle = WHEEL_CIRCUMFERENCE*((outside_wheel_count - inside_wheel_count)/DISC_HOLE_COUNT)/WHEEL_BASE
+//
+// The only variables are the outside_wheel_count and inside_wheel_count, so the constants are combined into an angle
+// factor:
+//
+//   angle_factor = WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT/WHEEL_BASE
+//   angle = angle_factor*(outside_wheel_count - inside_wheel_count)
+//
+// The inside wheel turns on a radius of WHEEL_BASE*inside_wheel_count/(outside_wheel_count - inside_wheel_count), and
+// the center of the robot on that plus half the wheel base, which simplifies to
+//
+//   center_radius = WHEEL_BASE*(outside_wheel_count + inside_wheel_count)/(2*(outside_wheel_count - inside_wheel_count))
+//
+// so both radii are a single integer division. The forward distance is center_radius*sin(angle) and the lateral
+// distance is center_radius*(1 - cos(angle)).
+
+FixedOdometry::FixedOdometry(double wheel_circumference, uint8_t disc_holes, double wheel_base)
+    :   _mmPerTick(q16_from_double(wheel_circumference/disc_holes)),
+        _wheelBase(q16_from_double(wheel_base)),
+        _angleFactor((int32_t)(wheel_circumference/disc_holes/wheel_base*16777216.0 + 0.5))
+{
+}
+
+// multiplies a Q16.16 number by an integer and divides by another. The product only needs 64 bits for large counts.
+static q16_t q16_mul_div(q16_t value, uint16_t multiplier, uint16_t divisor) {
+    int32_t limit = INT32_MAX/(multiplier > 0 ? multiplier : 1);
+    if (value <= limit) {
+        return (value*(int32_t)multiplier)/(int32_t)divisor;
+    }
+    return (q16_t)(((int64_t)value*multiplier)/divisor);
+}
+
+void FixedOdometry::step(uint16_t left_delta, uint16_t right_delta, OdometryStep& step) const {
+    if (left_delta == right_delta) {
+        step.forward = _mmPerTick*right_delta;
+        step.lateral = 0;
+        step.angle = 0;
+        step.radius = 0;
+        return;
+    }
+    uint16_t outside = right_delta > left_delta ? right_delta : left_delta;
+    uint16_t inside = right_delta > left_delta ? left_delta : right_delta;
+    uint16_t difference = outside - inside;
+
+    q16_t angle = (q16_mul_div(_angleFactor, difference, 128) + 1)/2;
+    q16_t center_radius = q16_mul_div(_wheelBase, outside + inside, 2*difference);
+    step.radius = q16_mul_div(_wheelBase, inside, difference);
+    step.forward = q16_mul(center_radius, q16_sin(angle));
+    q16_t lateral = q16_mul(center_radius, Q16_ONE - q16_cos(angle));
+    // the robot drifts towards the side it turns to
+    step.lateral = right_delta > left_delta ? lateral : -lateral;
+    step.angle = right_delta > left_delta ? angle : -angle;
+}
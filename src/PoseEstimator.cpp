@@ -0,0 +1,68 @@
+#include "PoseEstimator.h"
+
+const DataColumnType TRAJECTORY_TYPES[POSE_TRAJECTORY_COLUMNS] {
+    DATA_COLUMN_UINT32,         // 0
+    DATA_COLUMN_FLOAT32,        // 1
+    DATA_COLUMN_FLOAT32,        // 2
+    DATA_COLUMN_FLOAT32         // 3
+};
+
+const DataColumnFormat PoseEstimator::TRAJECTORY_FORMATS[POSE_TRAJECTORY_COLUMNS] {
+    {0, false},                 // 0
+    {1, true},                  // 1
+    {1, true},                  // 2
+    {1, true}                   // 3
+};
+
+static String trajectory_column_names[POSE_TRAJECTORY_COLUMNS] {
+    "timestamp",                // 0
+    "x",                        // 1
+    "y",                        // 2
+    "heading"                   // 3
+};
+
+// keeps the heading between -pi and pi
+static q16_t normalize_heading(q16_t heading) {
+    while (heading > Q16_PI) {
+        heading -= Q16_TWO_PI;
+    }
+    while (heading < -Q16_PI) {
+        heading += Q16_TWO_PI;
+    }
+    return heading;
+}
+
+PoseEstimator::PoseEstimator(int trajectory_rows)
+    :   _x(0),
+        _y(0),
+        _heading(0),
+        _trajectory(trajectory_column_names, TRAJECTORY_TYPES, trajectory_rows, DATA_TABLE_RING)
+{
+}
+
+PoseEstimator::~PoseEstimator() {
+}
+
+void PoseEstimator::reset(double x, double y, double heading) {
+    _x = q16_from_double(x);
+    _y = q16_from_double(y);
+    _heading = normalize_heading(q16_from_double(heading*(PI/180.0)));
+    _trajectory.clear();
+}
+
+void PoseEstimator::update(const OdometryStep& step, q16_t heading_change) {
+    // forward is (-sin, cos) of the heading and left is (-cos, -sin)
+    q16_t sin_heading = q16_sin(_heading);
+    q16_t cos_heading = q16_cos(_heading);
+    _x -= q16_mul(step.forward, sin_heading) + q16_mul(step.lateral, cos_heading);
+    _y += q16_mul(step.forward, cos_heading) - q16_mul(step.lateral, sin_heading);
+    rotate(heading_change);
+}
+
+void PoseEstimator::rotate(q16_t heading_change) {
+    _heading = normalize_heading(_heading + heading_change);
+}
+
+void PoseEstimator::record(uint32_t timestamp) {
+    _trajectory.append(timestamp, x(), y(), heading());
+}
@@ -0,0 +1,130 @@
+#include "PurePursuit.h"
+
+const float PURSUIT_END_TOLERANCE = 15.0;       // mm
+
+static float wrap_degrees(float angle) {
+    while (angle > 180.0) {
+        angle -= 360.0;
+    }
+    while (angle < -180.0) {
+        angle += 360.0;
+    }
+    return angle;
+}
+
+PurePursuit::PurePursuit(
+    float lookahead,
+    float cruise_speed,
+    float final_speed,
+    float deceleration,
+    float lateral_acceleration
+)   :   _lookahead(lookahead),
+        _cruiseSpeed(cruise_speed),
+        _finalSpeed(final_speed),
+        _deceleration(deceleration),
+        _lateralAcceleration(lateral_acceleration),
+        _path(nullptr),
+        _segment(0),
+        _complete(true)
+{
+}
+
+PurePursuit::~PurePursuit() {
+}
+
+void PurePursuit::start(const PointSequence& path) {
+    _path = &path;
+    _segment = 0;
+    _complete = (path.size() < 2);
+}
+
+float PurePursuit::segmentLength(uint16_t segment) const {
+    return (*_path)[segment].distance((*_path)[segment + 1]);
+}
+
+// Pure pursuit starts to turn once the lookahead point passes a corner, and turns hardest as the robot reaches the
+// corner, where the lookahead point is at about half of the corner's angle from the robot's heading.
+float PurePursuit::cornerSpeed(uint16_t point) const {
+    const Point& previous = (*_path)[point - 1];
+    const Point& corner = (*_path)[point];
+    const Point& next = (*_path)[point + 1];
+    float angle = fabs(wrap_degrees(corner.absolute_bearing(next) - previous.absolute_bearing(corner)));
+    float curvature = 2.0*sin(angle*(PI/360.0))/_lookahead;
+    if (curvature <= 0.0) {
+        return _cruiseSpeed;
+    }
+    return sqrt(_lateralAcceleration/curvature);
+}
+
+bool PurePursuit::update(float x, float y, float heading, PursuitCommand& command) {
+    if (_complete) {
+        return false;
+    }
+    uint16_t last = _path->size() - 1;
+
+    // project the robot onto its segment, moving on to the next segment once it is past the end of this one
+    float length;
+    float t;
+    while (true) {
+        const Point& start = (*_path)[_segment];
+        const Point& end = (*_path)[_segment + 1];
+        float dx = end.x() - start.x();
+        float dy = end.y() - start.y();
+        length = sqrt(dx*dx + dy*dy);
+        t = (length > 0.0) ? ((x - start.x())*dx + (y - start.y())*dy)/(length*length) : 1.0;
+        if (t < 1.0 || _segment + 1 >= last) {
+            break;
+        }
+        _segment++;
+    }
+    float remaining = (1.0 - constrain(t, 0.0, 1.0))*length;
+    for (uint16_t segment = _segment + 1; segment < last; segment++) {
+        remaining += segmentLength(segment);
+    }
+    if (_segment + 1 >= last && (t >= 1.0 || remaining < PURSUIT_END_TOLERANCE)) {
+        _complete = true;
+        return false;
+    }
+
+    // the lookahead point is the lookahead distance along the path from the projection, or the end of the path
+    uint16_t segment = _segment;
+    float along = constrain(t, 0.0, 1.0)*length + _lookahead;
+    float segment_length = length;
+    while (along > segment_length && segment + 1 < last) {
+        along -= segment_length;
+        segment++;
+        segment_length = segmentLength(segment);
+    }
+    float fraction = (segment_length > 0.0) ? min(1.0, along/segment_length) : 1.0;
+    const Point& start = (*_path)[segment];
+    const Point& end = (*_path)[segment + 1];
+    float target_x = start.x() + fraction*(end.x() - start.x());
+    float target_y = start.y() + fraction*(end.y() - start.y());
+
+    // the arc through the lookahead point that is tangent to the robot's heading
+    float dx = target_x - x;
+    float dy = target_y - y;
+    float distance = sqrt(dx*dx + dy*dy);
+    float alpha = wrap_degrees(atan2(-dx, dy)*(180.0/PI) - heading)*(PI/180.0);
+    command.curvature = (distance > 1.0) ? 2.0*sin(alpha)/distance : 0.0;
+
+    float speed = _cruiseSpeed;
+    if (command.curvature != 0.0) {
+        speed = min(speed, sqrt(_lateralAcceleration/fabs(command.curvature)));
+    }
+    // slow down ahead of the corners within braking distance, so that the robot is at each corner's speed by the time
+    // it starts to turn, a lookahead distance before the corner
+    float corner_distance = (1.0 - constrain(t, 0.0, 1.0))*length;
+    float braking_distance = _cruiseSpeed*_cruiseSpeed/(2.0*_deceleration) + _lookahead;
+    for (uint16_t point = _segment + 1; point < last && corner_distance < braking_distance; point++) {
+        float corner_speed = cornerSpeed(point);
+        float approach = max(0.0, corner_distance - _lookahead);
+        speed = min(speed, sqrt(corner_speed*corner_speed + 2.0*_deceleration*approach));
+        corner_distance += segmentLength(point);
+    }
+    speed = min(speed, sqrt(_finalSpeed*_finalSpeed + 2.0*_deceleration*remaining));
+
+    command.speed = max(speed, _finalSpeed);
+    command.remaining = remaining;
+    return true;
+}
@@ -0,0 +1,119 @@
+#include "RelayAutotuner.h"
+
+RelayAutotuner::RelayAutotuner(double relay_amplitude, double hysteresis, uint8_t cycles, unsigned long timeout_millis)
+    :   _relayAmplitude(relay_amplitude),
+        _hysteresis(hysteresis),
+        _cycles(cycles),
+        _timeoutMillis(timeout_millis),
+        _state(AUTOTUNE_IDLE),
+        _setPoint(0.0),
+        _output(0.0),
+        _startMillis(0),
+        _firstUpdate(false),
+        _cycleStartMillis(0),
+        _startedCycles(0),
+        _cycleMax(0.0),
+        _cycleMin(0.0),
+        _amplitudeSum(0.0),
+        _periodSumMillis(0),
+        _measuredCycles(0),
+        _ultimateGain(0.0),
+        _ultimatePeriod(0.0)
+{
+}
+
+RelayAutotuner::~RelayAutotuner() {
+}
+
+void RelayAutotuner::start(double set_point, unsigned long start_millis) {
+    _state = AUTOTUNE_RUNNING;
+    _setPoint = set_point;
+    _output = 0.0;
+    _startMillis = start_millis;
+    _firstUpdate = true;
+    _startedCycles = 0;
+    _amplitudeSum = 0.0;
+    _periodSumMillis = 0;
+    _measuredCycles = 0;
+    _ultimateGain = 0.0;
+    _ultimatePeriod = 0.0;
+}
+
+void RelayAutotuner::stop() {
+    if (_state == AUTOTUNE_RUNNING) {
+        _state = AUTOTUNE_FAILED;
+    }
+    _output = 0.0;
+}
+
+double RelayAutotuner::update(double measurement, unsigned long measurement_millis) {
+    if (_state != AUTOTUNE_RUNNING) {
+        return 0.0;
+    }
+    if (_firstUpdate) {
+        // a measurement from before the start is on a clock that was restarted since, so the time out counts from it
+        if ((long)(measurement_millis - _startMillis) < 0) {
+            _startMillis = measurement_millis;
+        }
+        _firstUpdate = false;
+    }
+    if (measurement_millis - _startMillis > _timeoutMillis) {
+        stop();
+        return 0.0;
+    }
+
+    _cycleMax = max(_cycleMax, measurement);
+    _cycleMin = min(_cycleMin, measurement);
+    if (_output == 0.0) {
+        _output = measurement < _setPoint ? _relayAmplitude : -_relayAmplitude;
+    } else if (_output > 0.0 && measurement > _setPoint + _hysteresis) {
+        // a cycle runs from one switch to the negative output to the next, so it holds one peak and one trough
+        _output = -_relayAmplitude;
+        finish_cycle(measurement_millis);
+        _cycleMax = measurement;
+        _cycleMin = measurement;
+    } else if (_output < 0.0 && measurement < _setPoint - _hysteresis) {
+        _output = _relayAmplitude;
+    }
+    return _state == AUTOTUNE_RUNNING ? _output : 0.0;
+}
+
+void RelayAutotuner::finish_cycle(unsigned long now) {
+    // the first cycle starts at the first switch, and the cycle after it still has the start up transient
+    if (_startedCycles >= 2) {
+        _amplitudeSum += (_cycleMax - _cycleMin)/2.0;
+        _periodSumMillis += now - _cycleStartMillis;
+        _measuredCycles++;
+    } else {
+        _startedCycles++;
+    }
+    _cycleStartMillis = now;
+    if (_measuredCycles >= _cycles) {
+        finish();
+    }
+}
+
+void RelayAutotuner::finish() {
+    double amplitude = _amplitudeSum/_measuredCycles;
+    if (amplitude <= _hysteresis) {
+        // the loop did not oscillate beyond the hysteresis, so there is nothing to measure
+        _state = AUTOTUNE_FAILED;
+        _output = 0.0;
+        return;
+    }
+    _ultimateGain = 4.0*_relayAmplitude/(PI*sqrt(amplitude*amplitude - _hysteresis*_hysteresis));
+    _ultimatePeriod = _periodSumMillis/(1000.0*_measuredCycles);
+    _state = AUTOTUNE_COMPLETE;
+    _output = 0.0;
+}
+
+PIDGains RelayAutotuner::gains() const {
+    // Tyreus-Luyben: kp = Ku/2.2, Ti = 2.2*Tu, Td = Tu/6.3
+    double kp = _ultimateGain/2.2;
+    PIDGains gains = {
+        (float)kp,
+        (float)(kp/(2.2*_ultimatePeriod)),
+        (float)(kp*_ultimatePeriod/6.3)
+    };
+    return gains;
+}
@@ -1,7 +1,9 @@
 #include "Robot.h"
 #include "DataLogger.h"
 #include "DataTable.h"
+#include "EEPROMRecord.h"
 #include "PIDController.h"
+#include "SDTableSpill.h"
 
 const int LEFT_MOTOR_ENABLE_PIN = 9;            // A motor
 const int LEFT_MOTOR_FORWARD_PIN = 6;           // A motor
@@ -16,40 +18,73 @@ const int RIGHT_ROTATION_COUNTER_PIN = 2;
 const int STATUS_LED_PIN = 13;
 const int MOVING_LED_PIN = 22;
 const int BUTTON_PIN = 26;
+const unsigned long BUTTON_LONG_PRESS_DURATION = 1500;  // milliseconds
 
 const int DISC_HOLE_COUNT = 20;
 
-const int CONTROLLER_SAMPLE_PERIOD = 80;        // milliseconds
+const uint32_t CONTROL_TICK_PERIOD = 10000;     // microseconds between control updates
+const int TELEMETRY_TICK_DIVIDER = 8;           // control ticks between telemetry rows, so rows are 80 ms apart
+const int MOVE_DATA_BLOCK_ROWS = 7;             // rows the move data table writes to SD at a time
+const uint32_t MOVE_DATA_SPILL_MICROS = 4000;   // the time a block takes to write to SD as one sector
+const unsigned long REVERSE_BRAKE_DURATION = 500;   // milliseconds
+const int POSE_TRAJECTORY_ROWS = 48;            // the trajectory keeps the last 48 poses, 768 bytes
 
 const double WHEEL_CIRCUMFERENCE = 214;         // millimeters
 const double WHEEL_BASE = 132.5;                // millimeters
 
+const q16_t RADIANS_TO_DEGREES = Q16(180.0/PI);
+const double WHEEL_HEADING_PER_TICK = WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT/WHEEL_BASE*(180.0/PI);   // degrees
+
 const uint8_t TARGET_SPEED = 100;               // 0-255
 const uint8_t MIN_SPEED = 75;                   // 0-255
+const double CRUISE_WHEEL_SPEED = 400.0;        // mm/s, roughly the wheel speed at TARGET_SPEED
+const double MOVE_ACCELERATION = 800.0;         // mm/s^2
+const double MOVE_DECELERATION = 600.0;         // mm/s^2
+const double MOVE_FINAL_SPEED = 60.0;           // mm/s, slow enough to stop at without a reverse brake
+const uint8_t TURN_MIN_POWER = 80;              // 0-255, the lowest power that reliably turns the robot in place
+const uint8_t TURN_MAX_POWER = 140;             // 0-255, keeps the turn rate within the gyro's 250 degrees/s range
+const float TURN_POWER_PER_DEGREE = 2.0;        // full power until 30 degrees before the power is cut
+const float TURN_COAST_FACTOR = 0.0006;         // degrees per (degree/s)^2, about 5 degrees of coast at 90 degrees/s
+const float TURN_COAST_LEARNING_RATE = 0.3;
+const float TURN_SETTLED_RATE = 5.0;            // degrees/s, below which a coasting turn has stopped
+const unsigned long TURN_COAST_TIMEOUT = 500;   // milliseconds
 
 const float HEADING_PID_CONTROLLER_KP = 3.0;
 const float HEADING_PID_CONTROLLER_KI = 0.1;
 const float HEADING_PID_CONTROLLER_KD = 0.3;
+const float HEADING_PID_DERIVATIVE_FILTER = 0.3;  // the gyro rate is noisy at the control rate
+const double HEADING_CORRECTION_SPEED = 4.0;    // mm/s of wheel speed difference per unit of heading control signal
+
+const uint8_t HEADING_GAINS_EEPROM_VERSION = 1;
+static_assert(
+    HEADING_GAINS_EEPROM_ADDRESS + sizeof(PIDGains) + EEPROM_RECORD_OVERHEAD <= LR_RATIO_EEPROM_ADDRESS,
+    "the heading gains overlap the speed model ratios in the EEPROM"
+);
+static_assert(
+    LR_RATIO_EEPROM_ADDRESS + POWER_RATIO_COUNT*sizeof(float) + EEPROM_RECORD_OVERHEAD <= TURN_MODEL_EEPROM_ADDRESS,
+    "the speed model ratios overlap the turn model in the EEPROM"
+);
+static_assert(
+    TURN_MODEL_EEPROM_ADDRESS + sizeof(float) + EEPROM_RECORD_OVERHEAD <= EEPROM_END_OF_RECORDS,
+    "the turn model runs past the end of the EEPROM records"
+);
+const double HEADING_AUTOTUNE_RELAY_AMPLITUDE = 5.0;        // control signal, 20 mm/s of wheel speed difference
+const double HEADING_AUTOTUNE_HYSTERESIS = 0.5;             // degrees, above the noise of the fused heading
+const uint8_t HEADING_AUTOTUNE_CYCLES = 4;
+const unsigned long HEADING_AUTOTUNE_TIMEOUT = 8000;        // milliseconds
+const int HEADING_AUTOTUNE_MOVE_DISTANCE = 4000;            // millimeters, 10 s at the cruise speed
+
+const double FOLLOW_LOOKAHEAD = 200.0;          // mm, about 1.5 wheel bases
+const double FOLLOW_LATERAL_ACCELERATION = 300.0;   // mm/s^2, 90 degree corners are taken at about 200 mm/s
+
+const float HEADING_FILTER_GYRO_VARIANCE_RATE = 0.5;    // degrees^2/s of gyro drift
+const float HEADING_FILTER_WHEEL_VARIANCE = 1.8;        // degrees^2, a wheel tick of difference is 4.6 degrees
+const float HEADING_FILTER_SLIP_VARIANCE = 0.005;       // degrees^2/mm of wheel slip
+
+const double WHEEL_SPEED_CONTROLLER_KP = 0.1;
+const double WHEEL_SPEED_CONTROLLER_KI = 0.5;
+const double WHEEL_SPEED_CONTROLLER_MAX_CORRECTION = 60;
 
-// Turning angle formula (in radians):
-//
-//   angle = WHEEL_CIRCUMFERENCE*((outside_wheel_count - inside_wheel_count)/DISC_HOLE_COUNT)/WHEEL_BASE
-//
-// The only variables are the outside_wheel_count and inside_wheel_count. We can calculate and turning angle
-// factor based off the contstant values.
-//
-//   angle_factor = WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT/WHEEL_BASE
-//
-// the turning angle is then:
-//
-//   angle = angle_factor*(outside_wheel_count - inside_wheel_count)
-
-const double TURNING_ANGLE_FACTOR = WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT/WHEEL_BASE;
-
-#define CALC_TURNING_ANGLE(outside_wheel_count, inside_wheel_count) (TURNING_ANGLE_FACTOR*((outside_wheel_count) - (inside_wheel_count)))
-#define CALC_TURNING_RADIUS(outside_wheel_count, inside_wheel_count) (WHEEL_BASE*inside_wheel_count/(outside_wheel_count - inside_wheel_count))
-#define CALC_HORIZONTAL_DISTANCE(turning_radius, turning_angle) ((turning_radius+WHEEL_BASE/2)*(1.0 - cos(turning_angle)))
-#define CALC_VERTICAL_DISTANCE(turning_radius, turning_angle, wheel_rotation_ticks) (sin(turning_angle) != 0.0 ? (turning_radius+WHEEL_BASE/2)*sin(turning_angle) : wheel_rotation_ticks*WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT)
 //
 // Interupt Service Routines
 //
@@ -63,9 +98,18 @@ void rightRotationCounterISR() {
     Robot::instance->handleRightWheelCounterISR();
 }
 
+// called from the control timer interrupt, where the wheel counters can be read without an ATOMIC_BLOCK
+void sampleControlTick(ControlTick& tick) {
+    tick.left_wheel_counter = Robot::instance->_leftWheelEncoder.count();
+    tick.right_wheel_counter = Robot::instance->_rightWheelEncoder.count();
+}
+
 
 Robot::Robot()
     :   _buttonPressed(false),
+        _buttonLongPress(false),
+        _buttonPressMillis(0),
+        _buttonEvent(BUTTON_NONE),
         _motorController(
             LEFT_MOTOR_ENABLE_PIN,
             LEFT_MOTOR_FORWARD_PIN,
@@ -76,8 +120,82 @@ Robot::Robot()
         ),
         _speedModel(DISC_HOLE_COUNT),
         _headingCalculator(),
-        _leftWheelCounter(0),
-        _rightWheelCounter(0),
+        _controlTimer(),
+        _headingController(
+            HEADING_PID_CONTROLLER_KP,
+            HEADING_PID_CONTROLLER_KI,
+            HEADING_PID_CONTROLLER_KD,
+            -30,
+            30
+        ),
+        _headingAutotuner(
+            HEADING_AUTOTUNE_RELAY_AMPLITUDE,
+            HEADING_AUTOTUNE_HYSTERESIS,
+            HEADING_AUTOTUNE_CYCLES,
+            HEADING_AUTOTUNE_TIMEOUT
+        ),
+        _saveHeadingGains(false),
+        _turnModel(
+            TURN_MIN_POWER,
+            TURN_MAX_POWER,
+            TURN_POWER_PER_DEGREE,
+            TURN_COAST_FACTOR,
+            TURN_COAST_LEARNING_RATE
+        ),
+        _leftSpeedController(
+            WHEEL_SPEED_CONTROLLER_KP,
+            WHEEL_SPEED_CONTROLLER_KI,
+            WHEEL_SPEED_CONTROLLER_MAX_CORRECTION
+        ),
+        _rightSpeedController(
+            WHEEL_SPEED_CONTROLLER_KP,
+            WHEEL_SPEED_CONTROLLER_KI,
+            WHEEL_SPEED_CONTROLLER_MAX_CORRECTION
+        ),
+        _moveProfile(
+            MOVE_ACCELERATION,
+            CRUISE_WHEEL_SPEED,
+            MOVE_DECELERATION,
+            MOVE_FINAL_SPEED
+        ),
+        _odometry(WHEEL_CIRCUMFERENCE, DISC_HOLE_COUNT, WHEEL_BASE),
+        _pose(POSE_TRAJECTORY_ROWS),
+        _headingFilter(
+            HEADING_FILTER_GYRO_VARIANCE_RATE,
+            HEADING_FILTER_WHEEL_VARIANCE,
+            HEADING_FILTER_SLIP_VARIANCE
+        ),
+        _poseHeading(0.0),
+        _motionState(MOTION_IDLE),
+        _motionStatus(MOTION_STATUS_NONE),
+        _motionCancelled(false),
+        _turnDegrees(0),
+        _turnResult(0),
+        _turnPower(0),
+        _turnCutoffHeading(0.0),
+        _turnCutoffRate(0.0),
+        _turnCutoffMillis(0),
+        _turnData(nullptr),
+        _moveTargetTicks(0),
+        _moveEndMillis(0),
+        _moveData(nullptr),
+        _moveDataSpill(nullptr),
+        _moveDataSpilled(false),
+        _moveDataSpills(0),
+        _moveDataSpillOverruns(0),
+        _pursuit(
+            FOLLOW_LOOKAHEAD,
+            CRUISE_WHEEL_SPEED,
+            MOVE_FINAL_SPEED,
+            MOVE_DECELERATION,
+            FOLLOW_LATERAL_ACCELERATION
+        ),
+        _followSpeed(0.0),
+        _brakeStartMillis(0),
+        _brakePowerA(0),
+        _brakePowerB(0),
+        _leftWheelEncoder(WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT),
+        _rightWheelEncoder(WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT),
         _statusLEDUpdateTime(millis()),
         _statusLEDUpdateInterval(1000)
 {
@@ -87,6 +205,14 @@ Robot::Robot()
         ERROR_LOG("Robot::Robot: instance already exists");
     }
 
+    _headingController.setDerivativeFilter(HEADING_PID_DERIVATIVE_FILTER);
+    load_heading_gains();
+    if (_speedModel.loadRatios(LR_RATIO_EEPROM_ADDRESS)) {
+        INFO_LOG(F("Robot::Robot: loaded the learned left/right power ratios"));
+    }
+    if (_turnModel.load(TURN_MODEL_EEPROM_ADDRESS)) {
+        INFO_LOG(F("Robot::Robot: loaded the learned turn coast model"));
+    }
     _motorController.stop();
 
     pinMode(STATUS_LED_PIN, OUTPUT);
@@ -102,7 +228,9 @@ Robot::Robot()
 }
 
 Robot::~Robot() {
-    // TODO Auto-generated destructor stub
+    delete _turnData;
+    delete _moveData;
+    delete _moveDataSpill;
 }
 
 int Robot::min_turn_angle() const {
@@ -113,12 +241,11 @@ int Robot::min_move_distance() const {
     return ceil(WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT);
 }
 void Robot::loop() {
-    // unset button press if button is not pressed
-    if (digitalRead(BUTTON_PIN) == HIGH) {
-        _buttonPressed = false;
-    }
-
+    update_button();
     _headingCalculator.update();
+    // the log file is only flushed while the robot is still, as the flush would hold up the control ticks
+    DataLogger::getInstance()->loop(!is_in_motion());
+    update_motion();
 
     if (millis() - _statusLEDUpdateTime > _statusLEDUpdateInterval) {
         _statusLEDUpdateTime = millis();
@@ -126,188 +253,313 @@ void Robot::loop() {
     }
 }
 
-// checks button state. Returns true if button is newly pressed
-bool Robot::buttonPressed() {
-    bool buttonPressed = false;
+void Robot::update_button() {
     // button is active low
-    if (digitalRead(BUTTON_PIN) == LOW) {
-        if (!_buttonPressed) {
-            DEBUG_LOG("Robot button pressed");
-            buttonPressed = true;
-        }
-        _buttonPressed = true;
-    } else {
-        _buttonPressed = false;
+    bool pressed = (digitalRead(BUTTON_PIN) == LOW);
+    if (pressed && !_buttonPressed) {
+        _buttonPressMillis = millis();
+        _buttonLongPress = false;
+    } else if (pressed && !_buttonLongPress && millis() - _buttonPressMillis >= BUTTON_LONG_PRESS_DURATION) {
+        DEBUG_LOG("Robot button long pressed");
+        _buttonLongPress = true;
+        _buttonEvent = BUTTON_LONG_PRESS;
+    } else if (!pressed && _buttonPressed && !_buttonLongPress) {
+        DEBUG_LOG("Robot button pressed");
+        _buttonEvent = BUTTON_SHORT_PRESS;
     }
-    return buttonPressed;
+    _buttonPressed = pressed;
+}
+
+ButtonEvent Robot::buttonEvent() {
+    ButtonEvent event = _buttonEvent;
+    _buttonEvent = BUTTON_NONE;
+    return event;
 }
 
 void Robot::handleLeftWheelCounterISR() {
-    _leftWheelCounter++;
+    _leftWheelEncoder.record_edge(micros());
 }
 
 void Robot::handleRightWheelCounterISR() {
-    _rightWheelCounter++;
+    _rightWheelEncoder.record_edge(micros());
 }
 
 unsigned long Robot::leftWheelCounter() const  {
-    unsigned long value = 0;
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        value = _leftWheelCounter;
-    };
-    return value;
+    return _leftWheelEncoder.count();
 }
 
 unsigned long Robot::rightWheelCounter() const {
-    unsigned long value = 0;
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        value = _rightWheelCounter;
-    };
-    return value;
+    return _rightWheelEncoder.count();
 }
 
 void Robot::resetWheelCounters() {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        _leftWheelCounter = 0;
-        _rightWheelCounter = 0;
-    }
+    _leftWheelEncoder.reset();
+    _rightWheelEncoder.reset();
 }
 
-int Robot::turn(int degrees) {
-const int NUM_DATA_COLUMNS = 7;
-    String column_headers[] {
-        "timestamp",                // 0
-        "left wheel counter",       // 1
-        "right wheel counter",      // 2
-        "heading",                  // 3
-        "target heading",           // 4
-        "heading error"             // 5
-        "power"                     // 6
-    };
-
+const DataColumnType TURN_DATA_TYPES[TURN_DATA_COLUMNS] {
+    DATA_COLUMN_UINT32,         // 0
+    DATA_COLUMN_UINT16,         // 1
+    DATA_COLUMN_UINT16,         // 2
+    DATA_COLUMN_FLOAT32,        // 3
+    DATA_COLUMN_INT16,          // 4
+    DATA_COLUMN_FLOAT32,        // 5
+    DATA_COLUMN_UINT8           // 6
+};
+const DataColumnFormat TURN_DATA_FORMATS[TURN_DATA_COLUMNS] {
+    {0, false},                 // 0
+    {0, false},                 // 1
+    {0, false},                 // 2
+    {2, false},                 // 3
+    {0, false},                 // 4
+    {2, false},                 // 5
+    {0, false}                  // 6
+};
+
+const DataColumnType MOVE_DATA_TYPES[MOVE_DATA_COLUMNS] {
+    DATA_COLUMN_UINT32,         // 0
+    DATA_COLUMN_UINT16,         // 1
+    DATA_COLUMN_UINT16,         // 2
+    DATA_COLUMN_UINT8,          // 3
+    DATA_COLUMN_UINT8,          // 4
+    DATA_COLUMN_UINT8,          // 5
+    DATA_COLUMN_UINT8,          // 6
+    DATA_COLUMN_FLOAT32,        // 7
+    DATA_COLUMN_FLOAT32,        // 8
+    DATA_COLUMN_FLOAT32,        // 9
+    DATA_COLUMN_FLOAT32,        // 10
+    DATA_COLUMN_FLOAT32,        // 11
+    DATA_COLUMN_FLOAT32,        // 12
+    DATA_COLUMN_UINT16,         // 13
+    DATA_COLUMN_FLOAT32,        // 14
+    DATA_COLUMN_FLOAT32,        // 15
+    DATA_COLUMN_FLOAT32,        // 16
+    DATA_COLUMN_FLOAT32,        // 17
+    DATA_COLUMN_FLOAT32,        // 18
+    DATA_COLUMN_FLOAT32,        // 19
+    DATA_COLUMN_FLOAT32         // 20
+};
+const DataColumnFormat MOVE_DATA_FORMATS[MOVE_DATA_COLUMNS] {
+    {0, false},                 // 0
+    {0, false},                 // 1
+    {0, false},                 // 2
+    {0, false},                 // 3
+    {0, false},                 // 4
+    {0, false},                 // 5
+    {0, false},                 // 6
+    {2, true},                  // 7
+    {2, true},                  // 8
+    {2, true},                  // 9
+    {2, true},                  // 10
+    {2, true},                  // 11
+    {2, true},                  // 12
+    {0, false},                 // 13
+    {8, true},                  // 14
+    {8, true},                  // 15
+    {1, true},                  // 16
+    {1, true},                  // 17
+    {1, true},                  // 18
+    {2, true},                  // 19
+    {2, true}                   // 20
+};
+
+MotionStatus Robot::motion_status() const {
+    return _motionStatus;
+}
 
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("Robot::turn: turning %d degrees"),
+bool Robot::start_turn(int degrees) {
+    if (is_in_motion()) {
+        return false;
+    }
+    DEBUG_EVENT(
+        EVENT_ROBOT_TURN_START,
+        "Robot::turn: turning %d degrees",
         degrees
     );
-    DEBUG_LOG(DataLogger::commonBuffer());
 
+    _turnDegrees = degrees;
+    _turnResult = 0;
+    _motionCancelled = false;
     if (abs(degrees) < min_turn_angle()) {
-        sprintf_P(
-            DataLogger::commonBuffer(),
-            PSTR("Robot::turn: turning angle (%d) is less than minimum turn angle magnitude (%d)"),
+        DEBUG_EVENT(
+            EVENT_ROBOT_TURN_TOO_SMALL,
+            "Robot::turn: turning angle (%d) is less than minimum turn angle magnitude (%d)",
             degrees,
             min_turn_angle()
         );
-        DEBUG_LOG(DataLogger::commonBuffer());
-        return 0;
+        _motionStatus = MOTION_STATUS_COMPLETE;
+        return true;
     }
-    DataTable<double> turn_data(NUM_DATA_COLUMNS, column_headers, 35);
+
+    String column_headers[TURN_DATA_COLUMNS] {
+        "timestamp",                // 0
+        "left wheel counter",       // 1
+        "right wheel counter",      // 2
+        "heading",                  // 3
+        "target heading",           // 4
+        "heading error",            // 5
+        "power"                     // 6
+    };
+    _turnData = new FixedDataTable<double, TURN_DATA_COLUMNS>(column_headers, TURN_DATA_TYPES, 35);
 
     // use the heading calculator to keep track of the heading
-    _headingCalculator.reset();
+    reset_heading();
 
-    uint8_t current_power = 80;
-    double heading_error = degrees;
+    set_turn_power(_turnModel.power(abs(degrees)));
 
-    unsigned long currentMillis = millis();
-    unsigned long lastCheckinMillis = currentMillis;
+    _turnData->append(
+        millis(),
+        this->leftWheelCounter(),
+        this->rightWheelCounter(),
+        _headingCalculator.getHeading(),
+        degrees,
+        degrees,
+        _turnPower
+    );
+    _lastTelemetryTick = 0;
+    _controlTimer.start(CONTROL_TICK_PERIOD, sampleControlTick);
+    _motionState = MOTION_TURNING;
+    _motionStatus = MOTION_STATUS_RUNNING;
+    return true;
+}
 
-    _motorController.setSpeed(current_power);
-    if (degrees > 0) {
+void Robot::set_turn_power(uint8_t power) {
+    _turnPower = power;
+    _motorController.setSpeed(power);
+    // the direction is set again to apply the PWM values
+    if (_turnDegrees > 0) {
         _motorController.backwardA();
         _motorController.forwardB();
     } else {
         _motorController.forwardA();
         _motorController.backwardB();
     }
+}
 
-    turn_data.append_row(
-        NUM_DATA_COLUMNS,
-        double(currentMillis),
-        double(this->leftWheelCounter()),
-        double(this->rightWheelCounter()),
-        _headingCalculator.getHeading(),
-        double(degrees),
-        heading_error,
-        double(current_power)
-    );
-    while ((heading_error = fabs(degrees - _headingCalculator.getHeading())) > this->min_turn_angle()) {
-        this->loop();
-        currentMillis = millis();
-        unsigned long deltaMillis = currentMillis - lastCheckinMillis;
-        if (deltaMillis > CONTROLLER_SAMPLE_PERIOD) {
-            lastCheckinMillis = currentMillis;
-            sprintf_P(
-                DataLogger::commonBuffer(),
-                PSTR("Robot::turn: heading error = %s"),
-                String(heading_error).c_str()
-            );
-            DEBUG_LOG(DataLogger::commonBuffer());
-
-            turn_data.append_row(
-                NUM_DATA_COLUMNS,
-                double(currentMillis),
-                double(this->leftWheelCounter()),
-                double(this->rightWheelCounter()),
-                _headingCalculator.getHeading(),
-                double(degrees),
-                heading_error,
-                double(current_power)
-            );
-        }
+void Robot::update_turn() {
+    float heading = _headingCalculator.getHeading();
+    float rate = _headingCalculator.getRate();
+    // positive while the turn is short of its target
+    float remaining = (_turnDegrees > 0) ? _turnDegrees - heading : heading - _turnDegrees;
+    float cutoff_angle = _turnModel.cutoffAngle(remaining, rate);
+    if (cutoff_angle <= 0.0) {
+        start_turn_coast(heading, rate);
+        return;
+    }
+    double heading_error = fabs(remaining);
+    ControlTick tick;
+    if (!_controlTimer.take_tick(tick)) {
+        return;
+    }
+    // the wheels can not tell which way they turn, so an in-place turn only has the gyro
+    _headingFilter.predict(_headingCalculator.getHeading(), _controlTimer.period_micros()/1000000.0);
+    set_turn_power(_turnModel.power(cutoff_angle));
+    if (tick.count - _lastTelemetryTick >= TELEMETRY_TICK_DIVIDER) {
+        _lastTelemetryTick = tick.count;
+        DEBUG_EVENT(
+            EVENT_ROBOT_TURN_HEADING_ERROR,
+            "Robot::turn: heading error = %.2f",
+            heading_error
+        );
 
+        _turnData->append(
+            tick.micros/1000,
+            tick.left_wheel_counter,
+            tick.right_wheel_counter,
+            _headingCalculator.getHeading(),
+            _turnDegrees,
+            heading_error,
+            _turnPower
+        );
+        _pose.rotate(take_pose_heading_change());
+        _pose.record(tick.micros/1000);
     }
+}
 
+void Robot::start_turn_coast(float heading, float rate) {
+    _motorController.stop();
+    _turnPower = 0;
+    _turnCutoffHeading = heading;
+    _turnCutoffRate = rate;
+    _turnCutoffMillis = millis();
+    _motionState = MOTION_TURN_COASTING;
+}
+
+void Robot::update_turn_coast() {
+    float heading = _headingCalculator.getHeading();
+    bool settled = fabs(_headingCalculator.getRate()) <= TURN_SETTLED_RATE;
+    if (!settled && millis() - _turnCutoffMillis < TURN_COAST_TIMEOUT) {
+        return;
+    }
+    float coast_angle = (_turnDegrees > 0) ? heading - _turnCutoffHeading : _turnCutoffHeading - heading;
+    // a coast that timed out or was cancelled was cut short while the robot was still turning, so its angle would
+    // bias the coast factor low
+    if (settled && !_motionCancelled) {
+        _turnModel.learn(_turnCutoffRate, coast_angle);
+    }
+    DEBUG_EVENT(
+        EVENT_ROBOT_TURN_COAST,
+        "Robot::turn: coasted %.2f degrees from %.1f degrees/s, coast factor = %.6f",
+        coast_angle,
+        _turnCutoffRate,
+        _turnModel.getCoastFactor()
+    );
+    finish_turn(fabs(_turnDegrees - heading));
+}
+
+void Robot::finish_turn(double heading_error) {
     _motorController.stop();
     _motorController.setSpeed(0);
-    turn_data.append_row(
-        NUM_DATA_COLUMNS,
-        double(currentMillis),
-        double(this->leftWheelCounter()),
-        double(this->rightWheelCounter()),
+    _controlTimer.stop();
+    _turnData->append(
+        millis(),
+        this->leftWheelCounter(),
+        this->rightWheelCounter(),
         _headingCalculator.getHeading(),
-        double(degrees),
+        _turnDegrees,
         heading_error,
-        double(current_power)
+        _turnPower
     );
 
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("Robot::turn: complete, target degress: %d, heading: %s"),
-        degrees,
-        String(_headingCalculator.getHeading(),2).c_str()
+    _turnResult = _headingCalculator.getHeading();
+    _pose.rotate(take_pose_heading_change());
+    _pose.record(millis());
+    DEBUG_EVENT(
+        EVENT_ROBOT_TURN_COMPLETE,
+        "Robot::turn: complete, target degress: %d, heading: %.2f",
+        _turnDegrees,
+        _headingCalculator.getHeading()
     );
-    DEBUG_LOG(DataLogger::commonBuffer());
 
+    if (_turnModel.changed()) {
+        _turnModel.save(TURN_MODEL_EEPROM_ADDRESS);
+    }
+
+    _controlTimer.log_statistics();
     DEBUG_LOG(F("Robot::turn: the turn data:"));
-    DataLogger::getInstance()->log_data_table(
-        turn_data,
-        [](double value, int col_num) -> String {
-            switch(col_num) {
-                case 0:
-                case 1:
-                case 2:
-                case 4:
-                case 6:
-                default:
-                    return String(value, 0);
-                    break;
-                case 3:
-                case 5:
-                    return String(value, 2);
-                    break;
-            }
-        }
-    );
+    DataLogger::getInstance()->log_data_table(*_turnData, TURN_DATA_FORMATS);
+    delete _turnData;
+    _turnData = nullptr;
 
-    return _headingCalculator.getHeading();
+    _motionState = MOTION_IDLE;
+    _motionStatus = _motionCancelled ? MOTION_STATUS_CANCELLED : MOTION_STATUS_COMPLETE;
 }
 
-Point Robot::move(int millimeters) {
-    const int NUM_DATA_COLUMNS = 16;
-    String column_headers[] {
+int Robot::turn(int degrees) {
+    if (!start_turn(degrees)) {
+        return 0;
+    }
+    while (is_in_motion()) {
+        this->loop();
+    }
+    return _turnResult;
+}
+
+bool Robot::start_move(int millimeters) {
+    if (is_in_motion()) {
+        return false;
+    }
+    String column_headers[MOVE_DATA_COLUMNS] {
         "timestamp",                        // 0
         "left wheel counter",               // 1
         "right wheel counter",              // 2
@@ -323,228 +575,554 @@ Point Robot::move(int millimeters) {
         "current gyro heading",             // 12
         "target wheel tick count",          // 13
         "cumulative stearing error",        // 14
-        "control signal"                    // 15
+        "control signal",                   // 15
+        "left wheel speed",                 // 16
+        "right wheel speed",                // 17
+        "profile speed",                    // 18
+        "fused heading",                    // 19
+        "heading variance"                  // 20
     };
-    DataTable<double> move_data(NUM_DATA_COLUMNS, column_headers, 35);
+    // with an SD card the table streams its rows to a scratch file in blocks of 7 rows, so the length of a move is
+    // not limited by RAM. At 66 bytes a row a block is the most that fits into one 512 byte sector, which the spill
+    // pads each block to.
+    _moveDataSpill = new SDTableSpill("log/move.tmp");
+    _moveData = new FixedDataTable<double, MOVE_DATA_COLUMNS>(
+        column_headers,
+        MOVE_DATA_TYPES,
+        2*MOVE_DATA_BLOCK_ROWS
+    );
+    if (_moveDataSpill->is_open()) {
+        _moveData->set_spill(_moveDataSpill);
+    }
+    _moveDataSpilled = false;
+    _moveDataSpills = 0;
+    _moveDataSpillOverruns = 0;
 
     // first calculate wheel rotation count for the distance.
-    uint32_t target_wheel_tick_count = (abs(millimeters) / WHEEL_CIRCUMFERENCE) * DISC_HOLE_COUNT + 1;
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("Robot::move: moving %d millimeters with target wheel tick count = %lu"),
+    _moveTargetTicks = (abs(millimeters) / WHEEL_CIRCUMFERENCE) * DISC_HOLE_COUNT + 1;
+    INFO_EVENT(
+        EVENT_ROBOT_MOVE_START,
+        "Robot::move: moving %d millimeters with target wheel tick count = %lu",
         millimeters,
-        target_wheel_tick_count
+        _moveTargetTicks
     );
-    INFO_LOG(DataLogger::commonBuffer());
 
-    // initialize speed model
-    _speedModel.setAverageSpeed(TARGET_SPEED);
-    _motorController.setSpeedA(_speedModel.getSpeedA());
-    _motorController.setSpeedB(_speedModel.getSpeedB());
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("Robot::move: initial left power = %d, initial right power = %d"),
+    _moveProfile.start(_moveTargetTicks*WHEEL_CIRCUMFERENCE/DISC_HOLE_COUNT);
+    start_wheel_speed_control();
+    DEBUG_EVENT(
+        EVENT_ROBOT_MOVE_INITIAL_POWER,
+        "Robot::move: initial left power = %d, initial right power = %d",
         _speedModel.getSpeedA(),
         _speedModel.getSpeedB()
     );
-    DEBUG_LOG(DataLogger::commonBuffer());
 
     // set up the controller
-    PIDController controller(
-        HEADING_PID_CONTROLLER_KP,
-        HEADING_PID_CONTROLLER_KI,
-        HEADING_PID_CONTROLLER_KD,
-        -30,
-        30
-    );
-    controller.setSetPoint(0.0); // keep heading straight
+    _headingController.reset();
+    _headingController.setSetPoint(0.0); // keep heading straight
     DEBUG_LOG(F("Robot::move: controller initialized"));
 
     // initialize counters
     this->resetWheelCounters();
-    uint32_t lastLeftWheelCounter = this->leftWheelCounter();
-    uint32_t lastRighWheelCounter = this->rightWheelCounter();
+    _lastLeftWheelCounter = 0;
+    _lastRightWheelCounter = 0;
+    _lastTelemetryTick = 0;
 
-    double forward_distance = 0.0;
-    double forward_distance_increment = 0.0;
-    double horizontal_displacement = 0.0;
-    double turning_angle = 0.0;
-    double turning_radius = 0.0;
-    double wheel_bearing = 0.0;
+    _forwardDistance = 0;
+    _horizontalDisplacement = 0;
+    _wheelBearing = 0;
+    _gyroHeading = 0.0;
+    _controlSignal = 0.0;
+    _moveResult = Point();
+    _motionCancelled = false;
 
-    _headingCalculator.reset();
+    reset_heading();
 
     digitalWrite(MOVING_LED_PIN, HIGH);
     DEBUG_LOG(F("Robot::move: starting motors"));
     _motorController.forward();
-    unsigned long currentMillis = millis();
-    unsigned long lastCheckinMillis = currentMillis;
-    while ( (this->leftWheelCounter() < target_wheel_tick_count) || (this->rightWheelCounter() < target_wheel_tick_count)) {
-        this->loop();
-        currentMillis = millis();
-        unsigned long deltaMillis = currentMillis - lastCheckinMillis;
-        if (deltaMillis > CONTROLLER_SAMPLE_PERIOD) {
-            lastCheckinMillis = currentMillis;
-            uint32_t curLeftWheelCounter = this->leftWheelCounter();
-            uint32_t curRightWheelCounter = this->rightWheelCounter();
-            uint32_t leftDelta = curLeftWheelCounter - lastLeftWheelCounter;
-            uint32_t rightDelta = curRightWheelCounter - lastRighWheelCounter;
-            lastLeftWheelCounter = curLeftWheelCounter;
-            lastRighWheelCounter = curRightWheelCounter;
-
-            if (rightDelta > leftDelta) {
-                turning_angle = CALC_TURNING_ANGLE(rightDelta, leftDelta);
-                turning_radius = CALC_TURNING_RADIUS(rightDelta, leftDelta);
-                forward_distance_increment = (turning_radius+WHEEL_BASE/2)*sin(turning_angle);
-                horizontal_displacement += CALC_HORIZONTAL_DISTANCE(turning_radius, turning_angle);
-            } else if (leftDelta > rightDelta) {
-                turning_angle = CALC_TURNING_ANGLE(leftDelta, rightDelta);
-                turning_radius = CALC_TURNING_RADIUS(leftDelta, rightDelta);
-                forward_distance_increment = (turning_radius+WHEEL_BASE/2)*sin(turning_angle);
-                turning_angle = -turning_angle;
-                horizontal_displacement += CALC_HORIZONTAL_DISTANCE(turning_radius, turning_angle);
-            } else {
-                turning_angle = 0.0;
-                forward_distance_increment = rightDelta*WHEEL_CIRCUMFERENCE/(double)DISC_HOLE_COUNT;
-            }
-
-            turning_angle *= 180.0/PI;
-            forward_distance += forward_distance_increment;
-
-            wheel_bearing += turning_angle;
-
-            double gyro_heading = _headingCalculator.getHeading();
-            double control_signal = controller.update(
-                gyro_heading,
-                currentMillis
-            );
-
-            uint8_t power_adjustment = (uint8_t)abs(control_signal);
-
-            // positive control signal means turn left, a negative control signal means turn right
-            if (control_signal > 0.0) {
-                _motorController.setSpeedA(_speedModel.getSpeedA() - power_adjustment);
-                _motorController.setSpeedB(_speedModel.getSpeedB() + power_adjustment);
-            } else {
-                _motorController.setSpeedA(_speedModel.getSpeedA() + power_adjustment);
-                _motorController.setSpeedB(_speedModel.getSpeedB() - power_adjustment);
-            }
-            // need to call forward() again to set the PWN values
-            _motorController.forward();
-
-            move_data.append_row(
-                NUM_DATA_COLUMNS,
-                double(currentMillis),
-                double(curLeftWheelCounter),
-                double(curRightWheelCounter),
-                double(leftDelta),
-                double(rightDelta),
-                double(_motorController.getSpeedA()),
-                double(_motorController.getSpeedB()),
-                forward_distance_increment,
-                forward_distance,
-                turning_angle,
-                turning_radius,
-                wheel_bearing,
-                gyro_heading,
-                double(target_wheel_tick_count),
-                controller.getCumulativeError(),
-                control_signal
-            );
+    _controlTimer.start(CONTROL_TICK_PERIOD, sampleControlTick);
+    _motionState = MOTION_MOVING;
+    _motionStatus = MOTION_STATUS_RUNNING;
+    return true;
+}
+
+void Robot::update_move() {
+    if ((this->leftWheelCounter() >= _moveTargetTicks) && (this->rightWheelCounter() >= _moveTargetTicks)) {
+        end_move();
+        return;
+    }
+    ControlTick tick;
+    uint32_t overruns = _controlTimer.overruns();
+    if (!_controlTimer.take_tick(tick)) {
+        return;
+    }
+    if (_moveDataSpilled) {
+        _moveDataSpillOverruns += _controlTimer.overruns() - overruns;
+        _moveDataSpilled = false;
+    }
+
+    double travelled = update_heading_filter(tick);
+    double tick_seconds = _controlTimer.period_micros()/1000000.0;
+
+    // the heading control runs on every tick, with the tick's exact time step
+    unsigned long tick_millis = _controlTimer.tick_millis(tick);
+    if (_headingAutotuner.is_running()) {
+        _controlSignal = _headingAutotuner.update(_headingFilter.getHeading(), tick_millis);
+        if (!_headingAutotuner.is_running()) {
+            finish_heading_autotune();
         }
+    } else {
+        _controlSignal = _headingController.update(_headingFilter.getHeading(), tick_millis);
+    }
+
+    // the heading control sets the difference between the wheel speeds around the speed the motion profile commands
+    // for the distance travelled so far, and the wheel speed controllers then hold the wheel speeds. Positive control
+    // signal means turn left, a negative control signal means turn right
+    double speed = _moveProfile.update(travelled, tick_seconds);
+    double speed_adjustment = _controlSignal*HEADING_CORRECTION_SPEED;
+    drive_wheels(speed - speed_adjustment, speed + speed_adjustment, tick_millis);
+
+    // the dead reckoning and telemetry run at the slower telemetry rate, as the wheel counters barely change
+    // within one control tick
+    if (tick.count - _lastTelemetryTick >= TELEMETRY_TICK_DIVIDER) {
+        _lastTelemetryTick = tick.count;
+        update_move_telemetry(tick);
+    }
+    service_move_data(tick);
+}
+
+double Robot::update_heading_filter(const ControlTick& tick) {
+    // the heading is the gyro heading fused with the wheel heading, which is exact while the wheels do not slip
+    double travelled = (tick.left_wheel_counter + tick.right_wheel_counter)*WHEEL_CIRCUMFERENCE/(2.0*DISC_HOLE_COUNT);
+    _gyroHeading = _headingCalculator.getHeading();
+    _headingFilter.predict(_gyroHeading, _controlTimer.period_micros()/1000000.0);
+    _headingFilter.correct(
+        ((double)tick.right_wheel_counter - (double)tick.left_wheel_counter)*WHEEL_HEADING_PER_TICK,
+        travelled
+    );
+    return travelled;
+}
+
+void Robot::drive_wheels(double left_speed, double right_speed, unsigned long tick_millis) {
+    _leftSpeedController.setTargetSpeed(left_speed);
+    _rightSpeedController.setTargetSpeed(right_speed);
+    _motorController.setSpeedA(_leftSpeedController.update(_leftWheelEncoder.filtered_speed(), tick_millis));
+    _motorController.setSpeedB(_rightSpeedController.update(_rightWheelEncoder.filtered_speed(), tick_millis));
+    // need to call forward() again to set the PWN values
+    _motorController.forward();
+}
+
+void Robot::step_pose(uint32_t left_counter, uint32_t right_counter, unsigned long millis, OdometryStep& step) {
+    _odometry.step(left_counter - _lastLeftWheelCounter, right_counter - _lastRightWheelCounter, step);
+    _lastLeftWheelCounter = left_counter;
+    _lastRightWheelCounter = right_counter;
+    _pose.update(step, take_pose_heading_change());
+    _pose.record(millis);
+}
+
+void Robot::service_move_data(const ControlTick& tick) {
+    // a block is written to SD after a tick has been processed, and only if it can be done before the next tick is
+    // due. If there is never the time, the table's append writes the block itself once both blocks are full
+    if (_controlTimer.micros_to_next_tick(tick) < MOVE_DATA_SPILL_MICROS) {
+        return;
+    }
+    if (_moveData->service()) {
+        _moveDataSpilled = true;
+        _moveDataSpills++;
     }
+}
+
+void Robot::update_move_telemetry(const ControlTick& tick) {
+    uint32_t leftDelta = tick.left_wheel_counter - _lastLeftWheelCounter;
+    uint32_t rightDelta = tick.right_wheel_counter - _lastRightWheelCounter;
+    OdometryStep step;
+    step_pose(tick.left_wheel_counter, tick.right_wheel_counter, tick.micros/1000, step);
+    q16_t turning_angle = q16_mul(step.angle, RADIANS_TO_DEGREES);
+    _forwardDistance += step.forward;
+    // x is positive to the right, see Point::absolute_bearing()
+    _horizontalDisplacement -= step.lateral;
+    _wheelBearing += turning_angle;
+
+    // at the cruise speed the wheel speed controllers hold both wheels at the same speed, so the powers they settle
+    // at are the left/right power ratio the speed model should have started with
+    if (!_headingAutotuner.is_running() && _moveProfile.getSpeed() >= _moveProfile.getCruiseSpeed()) {
+        _speedModel.learnRatio(_motorController.getSpeedA(), _motorController.getSpeedB(), leftDelta, rightDelta);
+    }
+
+    _moveData->append(
+        tick.micros/1000,
+        tick.left_wheel_counter,
+        tick.right_wheel_counter,
+        leftDelta,
+        rightDelta,
+        _motorController.getSpeedA(),
+        _motorController.getSpeedB(),
+        q16_to_double(step.forward),
+        q16_to_double(_forwardDistance),
+        q16_to_double(turning_angle),
+        q16_to_double(step.radius),
+        q16_to_double(_wheelBearing),
+        _gyroHeading,
+        _moveTargetTicks,
+        _headingController.getIntegralTerm(),
+        _controlSignal,
+        _leftWheelEncoder.filtered_speed(),
+        _rightWheelEncoder.filtered_speed(),
+        _moveProfile.getSpeed(),
+        _headingFilter.getHeading(),
+        _headingFilter.getVariance()
+    );
+}
+
+void Robot::end_move() {
     _motorController.stop();
-    // ensure that the robot has stopped moving by reversing for a short time
-    this->reverse_brake();
+    _controlTimer.stop();
+    _moveEndMillis = millis();
+    if (_headingAutotuner.is_running()) {
+        // the move ended before the oscillation could be measured
+        _headingAutotuner.stop();
+        finish_heading_autotune();
+    }
+    if (_motionCancelled) {
+        // a cancelled move may be at cruise speed, so ensure that the robot has stopped moving by reversing for a
+        // short time
+        start_reverse_brake();
+    } else {
+        // the motion profile has slowed the robot to its final speed, from which it stops by itself
+        finish_move();
+    }
+}
+
+void Robot::finish_move() {
     digitalWrite(MOVING_LED_PIN, LOW);
+    _controlTimer.log_statistics();
+    DEBUG_EVENT(
+        EVENT_ROBOT_MOVE_SPILL_STATISTICS,
+        "Robot::move: %u move data blocks spilled, overruns = %lu after a spill, %lu otherwise",
+        _moveDataSpills,
+        _moveDataSpillOverruns,
+        _controlTimer.overruns() - _moveDataSpillOverruns
+    );
+
+    // bring the pose up to date with the wheel ticks since the last telemetry step
+    OdometryStep step;
+    step_pose(this->leftWheelCounter(), this->rightWheelCounter(), _moveEndMillis, step);
+    _forwardDistance += step.forward;
+    _horizontalDisplacement -= step.lateral;
+    _wheelBearing += q16_mul(step.angle, RADIANS_TO_DEGREES);
 
     // capture final state
-    move_data.append_row(
-        NUM_DATA_COLUMNS,
-        double(currentMillis),
-        double(this->leftWheelCounter()),
-        double(this->rightWheelCounter()),
-        double(0),
-        double(0),
-        double(_motorController.getSpeedA()),
-        double(_motorController.getSpeedB()),
-        double(0),
-        forward_distance,
-        double(0),
-        double(0),
-        wheel_bearing,
+    _moveData->append(
+        _moveEndMillis,
+        this->leftWheelCounter(),
+        this->rightWheelCounter(),
+        0,
+        0,
+        _motorController.getSpeedA(),
+        _motorController.getSpeedB(),
+        0,
+        q16_to_double(_forwardDistance),
+        0,
+        0,
+        q16_to_double(_wheelBearing),
         _headingCalculator.getHeading(),
-        double(target_wheel_tick_count),
-        controller.getCumulativeError(),
-        0.0
+        _moveTargetTicks,
+        _headingController.getIntegralTerm(),
+        0.0,
+        0.0,
+        0.0,
+        0.0,
+        _headingFilter.getHeading(),
+        _headingFilter.getVariance()
     );
 
-    int final_speed_left = _speedModel.getSpeedA();
-    int final_speed_right = _speedModel.getSpeedB();
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("Robot::move: complete, left wheel counter : %lu, right wheel counter: %lu, left wheel power: %d, right wheel power: %d"),
+    DEBUG_EVENT(
+        EVENT_ROBOT_MOVE_COMPLETE,
+        "Robot::move: complete, left wheel counter : %lu, right wheel counter: %lu, left wheel power: %d, right wheel power: %d",
         this->leftWheelCounter(),
         this->rightWheelCounter(),
-        final_speed_left,
-        final_speed_right
+        _speedModel.getSpeedA(),
+        _speedModel.getSpeedB()
     );
-    DEBUG_LOG(DataLogger::commonBuffer());
+
+    if (_saveHeadingGains) {
+        PIDGains gains = _headingController.getGains();
+        write_eeprom_record(HEADING_GAINS_EEPROM_ADDRESS, HEADING_GAINS_EEPROM_VERSION, &gains, sizeof(gains));
+        _saveHeadingGains = false;
+    }
+    if (_speedModel.ratiosChanged()) {
+        _speedModel.saveRatios(LR_RATIO_EEPROM_ADDRESS);
+    }
 
     DEBUG_LOG(F("Robot::move: the movement data:\n"));
-    DataLogger::getInstance()->log_data_table(
-        move_data,
-        [](double value, int col_num) -> String {
-            switch(col_num) {
-                case 0:
-                case 1:
-                case 2:
-                case 3:
-                case 4:
-                case 5:
-                case 6:
-                case 13:
-                    return String(value, 0);
-                    break;
-                default:
-                    return String(value, 2);
-                    break;
-                case 14:
-                case 15:
-                    if (value == 0.0) {
-                        return String("0");
-                    } else {
-                        return String(value, 8);
-                    }
-                    break;
-                case 7:
-                case 8:
-                case 9:
-                case 10:
-                case 11:
-                case 12:
-                    if (value == 0.0) {
-                        return String("0");
-                    } else {
-                        return String(value, 2);
-                    }
-                    break;
-            }
+    DataLogger::getInstance()->log_data_table(*_moveData, MOVE_DATA_FORMATS);
+    delete _moveData;
+    _moveData = nullptr;
+    delete _moveDataSpill;
+    _moveDataSpill = nullptr;
+
+    _moveResult = Point(q16_to_double(_horizontalDisplacement), q16_to_double(_forwardDistance));
+    _motionState = MOTION_IDLE;
+    _motionStatus = _motionCancelled ? MOTION_STATUS_CANCELLED : MOTION_STATUS_COMPLETE;
+}
+
+Point Robot::move(int millimeters) {
+    if (!start_move(millimeters)) {
+        return Point();
+    }
+    while (is_in_motion()) {
+        this->loop();
+    }
+    return _moveResult;
+}
+
+void Robot::start_wheel_speed_control() {
+    // initialize speed model, which is the feedforward of the wheel speed controllers
+    _speedModel.setAverageSpeed(TARGET_SPEED);
+    _leftSpeedController.setFeedforward(MIN_SPEED, _speedModel.getSpeedA(), CRUISE_WHEEL_SPEED);
+    _rightSpeedController.setFeedforward(MIN_SPEED, _speedModel.getSpeedB(), CRUISE_WHEEL_SPEED);
+    _leftSpeedController.reset();
+    _rightSpeedController.reset();
+    _speedModel.clearObservations();
+    _leftSpeedController.setTargetSpeed(MOVE_FINAL_SPEED);
+    _rightSpeedController.setTargetSpeed(MOVE_FINAL_SPEED);
+    _motorController.setSpeedA(_speedModel.getSpeedA());
+    _motorController.setSpeedB(_speedModel.getSpeedB());
+}
+
+bool Robot::start_follow(const PointSequence& path) {
+    if (is_in_motion() || path.size() < 2) {
+        return false;
+    }
+    INFO_EVENT(
+        EVENT_ROBOT_FOLLOW_START,
+        "Robot::follow: following a path of %u points from (%.0f,%.0f), heading = %.1f",
+        path.size(),
+        _pose.x(),
+        _pose.y(),
+        _pose.heading()
+    );
+    _pursuit.start(path);
+    _pursuitCommand.curvature = 0.0;
+    _pursuitCommand.speed = MOVE_FINAL_SPEED;
+    _pursuitCommand.remaining = 0.0;
+    _followSpeed = MOVE_FINAL_SPEED;
+    start_wheel_speed_control();
+
+    this->resetWheelCounters();
+    _lastLeftWheelCounter = 0;
+    _lastRightWheelCounter = 0;
+    _lastTelemetryTick = 0;
+    _motionCancelled = false;
+    reset_heading();
+
+    digitalWrite(MOVING_LED_PIN, HIGH);
+    _motorController.forward();
+    _controlTimer.start(CONTROL_TICK_PERIOD, sampleControlTick);
+    _motionState = MOTION_FOLLOWING;
+    _motionStatus = MOTION_STATUS_RUNNING;
+    return true;
+}
+
+void Robot::update_follow() {
+    ControlTick tick;
+    if (!_controlTimer.take_tick(tick)) {
+        return;
+    }
+    update_heading_filter(tick);
+
+    // the pose, and so the arc to steer, is updated at the telemetry rate, as the wheel counters barely change
+    // within one control tick
+    if (tick.count - _lastTelemetryTick >= TELEMETRY_TICK_DIVIDER) {
+        _lastTelemetryTick = tick.count;
+        OdometryStep step;
+        step_pose(tick.left_wheel_counter, tick.right_wheel_counter, tick.micros/1000, step);
+        if (!_pursuit.update(_pose.x(), _pose.y(), _pose.heading(), _pursuitCommand)) {
+            end_follow();
+            return;
         }
+    }
+
+    // the speed comes down as soon as the path requires it, which the pursuit plans ahead for, and goes up at the
+    // move acceleration. The wheel speeds differ by the arc's curvature
+    double tick_seconds = _controlTimer.period_micros()/1000000.0;
+    _followSpeed = min(_pursuitCommand.speed, _followSpeed + MOVE_ACCELERATION*tick_seconds);
+    double speed_adjustment = _followSpeed*_pursuitCommand.curvature*WHEEL_BASE/2.0;
+    drive_wheels(_followSpeed - speed_adjustment, _followSpeed + speed_adjustment, _controlTimer.tick_millis(tick));
+}
+
+void Robot::end_follow() {
+    _motorController.stop();
+    _controlTimer.stop();
+    digitalWrite(MOVING_LED_PIN, LOW);
+    _controlTimer.log_statistics();
+
+    // bring the pose up to date with the wheel ticks since the last telemetry step
+    OdometryStep step;
+    step_pose(this->leftWheelCounter(), this->rightWheelCounter(), millis(), step);
+
+    INFO_EVENT(
+        EVENT_ROBOT_FOLLOW_COMPLETE,
+        "Robot::follow: stopped at (%.0f,%.0f), heading = %.1f, on segment %u",
+        _pose.x(),
+        _pose.y(),
+        _pose.heading(),
+        _pursuit.segment()
+    );
+    _motionState = MOTION_IDLE;
+    _motionStatus = _motionCancelled ? MOTION_STATUS_CANCELLED : MOTION_STATUS_COMPLETE;
+}
+
+bool Robot::start_heading_autotune() {
+    if (!start_move(HEADING_AUTOTUNE_MOVE_DISTANCE)) {
+        return false;
+    }
+    INFO_EVENT(
+        EVENT_ROBOT_AUTOTUNE_START,
+        "Robot::autotune: tuning the heading loop with a relay amplitude of %.2f",
+        HEADING_AUTOTUNE_RELAY_AMPLITUDE
+    );
+    // the autotuner is updated with the control tick times, which start from 0 with the control timer
+    _headingAutotuner.start(0.0, 0);
+    return true;
+}
+
+void Robot::finish_heading_autotune() {
+    if (_headingAutotuner.state() != AUTOTUNE_COMPLETE) {
+        WARNING_EVENT(
+            EVENT_ROBOT_AUTOTUNE_FAILED,
+            "Robot::autotune: failed to measure the heading oscillation, keeping the gains"
+        );
+        return;
+    }
+    PIDGains gains = _headingAutotuner.gains();
+    INFO_EVENT(
+        EVENT_ROBOT_AUTOTUNE_COMPLETE,
+        "Robot::autotune: ultimate gain = %.3f, ultimate period = %.3f s, kp = %.3f, ki = %.3f, kd = %.3f",
+        _headingAutotuner.ultimateGain(),
+        _headingAutotuner.ultimatePeriod(),
+        gains.kp,
+        gains.ki,
+        gains.kd
     );
+    // the rest of the move steers with the new gains, starting from a clean integral
+    _headingController.setGains(gains);
+    _headingController.reset();
+    // each EEPROM byte takes 3.3 ms to write, so the gains are saved once the move is over
+    _saveHeadingGains = true;
+}
 
-    return Point(horizontal_displacement, forward_distance);
+void Robot::load_heading_gains() {
+    PIDGains gains;
+    if (read_eeprom_record(HEADING_GAINS_EEPROM_ADDRESS, HEADING_GAINS_EEPROM_VERSION, &gains, sizeof(gains))
+            && gains.kp > 0.0 && gains.ki >= 0.0 && gains.kd >= 0.0) {
+        _headingController.setGains(gains);
+    }
+    log_heading_gains();
 }
 
-void Robot::reverse_brake() {
-    uint8_t current_powerA = _motorController.getSpeedA();
-    uint8_t current_powerB = _motorController.getSpeedB();
+void Robot::log_heading_gains() const {
+    PIDGains gains = _headingController.getGains();
+    INFO_EVENT(
+        EVENT_ROBOT_HEADING_GAINS,
+        "Robot: heading gains kp = %.3f, ki = %.3f, kd = %.3f",
+        gains.kp,
+        gains.ki,
+        gains.kd
+    );
+}
+
+void Robot::start_reverse_brake() {
+    _brakePowerA = _motorController.getSpeedA();
+    _brakePowerB = _motorController.getSpeedB();
     // set the speed to a low value that is below the torque threshold that will cause the robot to move.
     // Still, this reverse torque will cause the robot to brake..
     _motorController.setSpeed(50);
     _motorController.backward();
-    delay(500);
+    _brakeStartMillis = millis();
+    _motionState = MOTION_BRAKING;
+}
+
+void Robot::update_reverse_brake() {
+    if (millis() - _brakeStartMillis < REVERSE_BRAKE_DURATION) {
+        return;
+    }
     _motorController.stop();
-    _motorController.setSpeedA(current_powerA);
-    _motorController.setSpeedB(current_powerB);
-}
\ No newline at end of file
+    _motorController.setSpeedA(_brakePowerA);
+    _motorController.setSpeedB(_brakePowerB);
+    finish_move();
+}
+
+void Robot::update_motion() {
+    switch (_motionState) {
+        case MOTION_TURNING:
+            update_turn();
+            break;
+        case MOTION_TURN_COASTING:
+            update_turn_coast();
+            break;
+        case MOTION_MOVING:
+            update_move();
+            break;
+        case MOTION_BRAKING:
+            update_reverse_brake();
+            break;
+        case MOTION_FOLLOWING:
+            update_follow();
+            break;
+        case MOTION_IDLE:
+        default:
+            break;
+    }
+}
+
+void Robot::cancel_motion() {
+    switch (_motionState) {
+        case MOTION_TURNING:
+            _motionCancelled = true;
+            finish_turn(fabs(_turnDegrees - _headingCalculator.getHeading()));
+            break;
+        case MOTION_TURN_COASTING:
+            // the motors are already off, so let the coast finish
+            _motionCancelled = true;
+            break;
+        case MOTION_MOVING:
+            _motionCancelled = true;
+            end_move();
+            break;
+        case MOTION_BRAKING:
+            // the robot is already stopping, so let the brake finish
+            _motionCancelled = true;
+            break;
+        case MOTION_FOLLOWING:
+            _motionCancelled = true;
+            end_follow();
+            break;
+        case MOTION_IDLE:
+        default:
+            break;
+    }
+}
+
+q16_t Robot::take_pose_heading_change() {
+    // bring the fused heading up to date with the gyro since the last control tick
+    _headingFilter.predict(_headingCalculator.getHeading(), 0.0);
+    float heading = _headingFilter.getHeading();
+    q16_t change = q16_from_double((heading - _poseHeading)*(PI/180.0));
+    _poseHeading = heading;
+    return change;
+}
+
+void Robot::reset_heading() {
+    // keep the rotation since the last pose update before the heading starts again from zero
+    _pose.rotate(take_pose_heading_change());
+    _headingCalculator.reset();
+    _headingFilter.reset();
+    _poseHeading = 0.0;
+}
+
+void Robot::reset_pose(double x, double y, double heading) {
+    _pose.reset(x, y, heading);
+    _headingFilter.predict(_headingCalculator.getHeading(), 0.0);
+    _poseHeading = _headingFilter.getHeading();
+}
@@ -0,0 +1,79 @@
+#include "SDTableSpill.h"
+
+SDTableSpill::SDTableSpill(const char* fileName)
+    :   _file(),
+        _blockSize(0),
+        _numBlocks(0)
+{
+    strncpy(_fileName, fileName, SD_TABLE_SPILL_FILE_NAME_SIZE - 1);
+    _fileName[SD_TABLE_SPILL_FILE_NAME_SIZE - 1] = '\0';
+    open();
+}
+
+SDTableSpill::~SDTableSpill() {
+    if (_file) {
+        _file.close();
+        SD.remove(_fileName);
+    }
+}
+
+void SDTableSpill::open(void) {
+    if (SD.exists(_fileName)) {
+        SD.remove(_fileName);
+    }
+    _file = SD.open(_fileName, FILE_WRITE);
+    _blockSize = 0;
+    _numBlocks = 0;
+}
+
+bool SDTableSpill::append(const uint8_t* data, size_t size) {
+    if (!_file || size == 0 || size > SD_TABLE_SPILL_SECTOR_SIZE || (_blockSize != 0 && size != _blockSize)) {
+        return false;
+    }
+    // reads move the position, so go back to the start of the next sector first
+    if (!_file.seek(_numBlocks*SD_TABLE_SPILL_SECTOR_SIZE) || _file.write(data, size) != size) {
+        return false;
+    }
+    // fill the rest of the sector so that the card writes it at once and the next block starts on a new sector
+    const uint8_t padding[16] = { 0 };
+    for (size_t left = SD_TABLE_SPILL_SECTOR_SIZE - size; left > 0; ) {
+        size_t n = left < sizeof(padding) ? left : sizeof(padding);
+        if (_file.write(padding, n) != n) {
+            return false;
+        }
+        left -= n;
+    }
+    _blockSize = size;
+    _numBlocks++;
+    return true;
+}
+
+bool SDTableSpill::read(uint32_t offset, uint8_t* data, size_t size) {
+    if (!_file || _blockSize == 0) {
+        return false;
+    }
+    // the table's offsets count the appended bytes only, so skip the padding of the blocks before the offset
+    while (size > 0) {
+        uint32_t block = offset/_blockSize;
+        size_t start = offset % _blockSize;
+        size_t n = _blockSize - start < size ? _blockSize - start : size;
+        if (block >= _numBlocks
+            || !_file.seek(block*SD_TABLE_SPILL_SECTOR_SIZE + start)
+            || _file.read(data, n) != (int)n
+        ) {
+            return false;
+        }
+        offset += n;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+void SDTableSpill::clear() {
+    if (!_file) {
+        return;
+    }
+    _file.close();
+    open();
+}
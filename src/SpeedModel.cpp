@@ -1,11 +1,11 @@
 #include "SpeedModel.h"
 #include "DataLogger.h"
+#include "EEPROMRecord.h"
 
 // the LR Power Ratio table is used to adjust the left/right power ratio based on the
 // requested power level. The table was produced by setting both motors to the same
 // power level and measuring the left/right ratio. The table is used to interpolate
-// between the measured values.
-#define POWER_RATIO_COUNT 12
+// between the measured values. These are the starting values, which are refined by learnRatio().
 const int lrRatioPowerLevel[POWER_RATIO_COUNT] = {
     70,
     80,
@@ -38,14 +38,24 @@ const double lrRatioValue[POWER_RATIO_COUNT] = {
 
 const uint8_t MIN_POWER_SETTING = 70;
 
+const uint8_t LR_RATIO_EEPROM_VERSION = 1;
+const uint32_t LR_RATIO_LEARNING_TICKS = 40;    // wheel ticks per wheel per learning step, about 2 wheel turns
+const float LR_RATIO_LEARNING_RATE = 0.2;       // the fraction of the observed error a learning step corrects
+const float LR_RATIO_MAX_STEP = 0.01;           // the largest change of an entry per learning step
+const float LR_RATIO_MIN = 0.8;
+const float LR_RATIO_MAX = 1.2;
+
 SpeedModel::SpeedModel(
     uint32_t wheelDiscHoles
 )   :   _wheelDiscHoles(wheelDiscHoles),
-        _averageSpeed(0.0),
-        _lrRatio(1.0),
         _speedA(0),
-        _speedB(0)
+        _speedB(0),
+        _lrRatiosChanged(false)
 {
+    for (int i = 0; i < POWER_RATIO_COUNT; i++) {
+        _lrRatios[i] = lrRatioValue[i];
+    }
+    buildSpeedTable(0, 255);
     this->reset();
 }
 
@@ -53,62 +63,114 @@ SpeedModel::~SpeedModel() {
 
 }
 
-void SpeedModel::setAverageSpeed(uint8_t speed) {
-   double leftRightRatio = 1.0;
+// Interpolates the left/right ratio for a power level. The ratio is `(1 - fraction)*_lrRatios[index] +
+// fraction*_lrRatios[index + 1]`, and power levels outside of the table take the ratio of the nearest end.
+double SpeedModel::interpolateRatio(uint8_t speed, int& index, double& fraction) const {
     if (speed <= lrRatioPowerLevel[0]) {
-        speed = lrRatioPowerLevel[0];
-        leftRightRatio = lrRatioValue[0];
-    } else {
-        // first, find the first entry into the lrRatioPowerLevel array that is 
-        // less than or equal to the power level. If the first entry is greater
-        // than the power level, then set the left/right ratio to the first entry
-        for (int i = 0; i < POWER_RATIO_COUNT; i++) {
-            if (lrRatioPowerLevel[i] > speed) {
-                if (i < POWER_RATIO_COUNT - 1) {
-                    sprintf_P(
-                        DataLogger::commonBuffer(),
-                        PSTR("SpeedModel::setAverageSpeed: Interpolating between %d and %d for power level %hu"),
-                        lrRatioPowerLevel[i-1],
-                        lrRatioPowerLevel[i],
-                        speed
-                    );
-                    DEBUG_LOG(DataLogger::commonBuffer());
-                    // interpolate this value and the next value
-                    leftRightRatio = lrRatioValue[i]
-                        + (speed - lrRatioPowerLevel[i]) * (lrRatioValue[i] - lrRatioValue[i-1])
-                                                        / (lrRatioPowerLevel[i] - lrRatioPowerLevel[i-1]);
-                } else {
-                    leftRightRatio = lrRatioValue[i];
-                }
-                break;
-            }
-            if (i == POWER_RATIO_COUNT - 1) {
-                speed = lrRatioPowerLevel[POWER_RATIO_COUNT - 1];
-                leftRightRatio = lrRatioValue[POWER_RATIO_COUNT - 1];
-            }
+        index = 0;
+        fraction = 0.0;
+        return _lrRatios[0];
+    }
+    for (int i = 1; i < POWER_RATIO_COUNT; i++) {
+        if (lrRatioPowerLevel[i] >= speed) {
+            index = i - 1;
+            fraction = double(speed - lrRatioPowerLevel[i-1])/(lrRatioPowerLevel[i] - lrRatioPowerLevel[i-1]);
+            return _lrRatios[i-1] + fraction*(_lrRatios[i] - _lrRatios[i-1]);
         }
     }
+    index = POWER_RATIO_COUNT - 1;
+    fraction = 0.0;
+    return _lrRatios[POWER_RATIO_COUNT - 1];
+}
+
+void SpeedModel::buildSpeedTable(uint8_t first_power, uint8_t last_power) {
+    int index = 0;
+    for (int power = first_power; power <= last_power; power++) {
+        // powers below the table are raised to its lowest level
+        int speed = max(power, lrRatioPowerLevel[0]);
+        while (index < POWER_RATIO_COUNT - 2 && lrRatioPowerLevel[index + 1] < speed) {
+            index++;
+        }
+        float fraction = float(speed - lrRatioPowerLevel[index])/(lrRatioPowerLevel[index + 1] - lrRatioPowerLevel[index]);
+        float ratio = _lrRatios[index] + fraction*(_lrRatios[index + 1] - _lrRatios[index]);
+        _speedBTable[power] = constrain((int)(speed*ratio), MIN_POWER_SETTING, 255);
+    }
+}
+
+void SpeedModel::setAverageSpeed(uint8_t speed) {
+    _speedA = max(speed, MIN_POWER_SETTING);
+    _speedB = _speedBTable[speed];
+}
+
+void SpeedModel::learnRatio(uint8_t left_power, uint8_t right_power, uint32_t left_ticks, uint32_t right_ticks) {
+    _observedLeftPower += left_power;
+    _observedRightPower += right_power;
+    _observationCount++;
+    _observedLeftTicks += left_ticks;
+    _observedRightTicks += right_ticks;
+    if (_observedLeftTicks < LR_RATIO_LEARNING_TICKS || _observedRightTicks < LR_RATIO_LEARNING_TICKS) {
+        return;
+    }
+
+    // close to equal speeds the wheel speed is about proportional to the power, so the right power that would have
+    // matched the left wheel's speed is the right power scaled by the tick ratio
+    double left_power_average = double(_observedLeftPower)/_observationCount;
+    double right_power_average = double(_observedRightPower)/_observationCount;
+    double observed_ratio = right_power_average*_observedLeftTicks/(left_power_average*_observedRightTicks);
+    clearObservations();
+
+    int index;
+    double fraction;
+    double error = observed_ratio - interpolateRatio(round(left_power_average), index, fraction);
+    // each of the two entries around the power level learns in proportion to its interpolation weight
+    for (int i = 0; i < 2 && index + i < POWER_RATIO_COUNT; i++) {
+        double weight = (i == 0) ? 1.0 - fraction : fraction;
+        float step = constrain(LR_RATIO_LEARNING_RATE*weight*error, -LR_RATIO_MAX_STEP, LR_RATIO_MAX_STEP);
+        _lrRatios[index + i] = constrain(_lrRatios[index + i] + step, LR_RATIO_MIN, LR_RATIO_MAX);
+    }
+    _lrRatiosChanged = true;
 
-    _speedA = speed;
-    _speedB = speed * leftRightRatio;
-    _averageSpeed = (double(_speedA) + double(_speedB))/ 2.0;
-    _lrRatio = leftRightRatio;
-
-    sprintf_P(
-        DataLogger::commonBuffer(),
-        PSTR("SpeedModel::setAverageSpeed: Setting average speed to %s and left/right ratio to %s, speed requested = %hu"),
-        String(_averageSpeed,5).c_str(),
-        String(leftRightRatio,5).c_str(),
-        speed
+    // the two entries are interpolated with their neighbours, and the lowest entry is also used below the table
+    buildSpeedTable(
+        index > 0 ? lrRatioPowerLevel[index - 1] : 0,
+        lrRatioPowerLevel[min(index + 2, POWER_RATIO_COUNT - 1)]
     );
-    DEBUG_LOG(DataLogger::commonBuffer());
+}
+
+void SpeedModel::clearObservations() {
+    _observedLeftPower = 0;
+    _observedRightPower = 0;
+    _observationCount = 0;
+    _observedLeftTicks = 0;
+    _observedRightTicks = 0;
+}
+
+bool SpeedModel::loadRatios(int address) {
+    float ratios[POWER_RATIO_COUNT];
+    if (!read_eeprom_record(address, LR_RATIO_EEPROM_VERSION, ratios, sizeof(ratios))) {
+        return false;
+    }
+    for (int i = 0; i < POWER_RATIO_COUNT; i++) {
+        // NaN fails both comparisons
+        if (!(ratios[i] >= LR_RATIO_MIN && ratios[i] <= LR_RATIO_MAX)) {
+            return false;
+        }
+    }
+    memcpy(_lrRatios, ratios, sizeof(ratios));
+    _lrRatiosChanged = false;
+    buildSpeedTable(0, 255);
+    return true;
+}
+
+void SpeedModel::saveRatios(int address) {
+    write_eeprom_record(address, LR_RATIO_EEPROM_VERSION, _lrRatios, sizeof(_lrRatios));
+    _lrRatiosChanged = false;
 }
 
 void SpeedModel::reset() {
-    _averageSpeed = 0.0;
-    _lrRatio = 1.0;
     _speedA = 0;
     _speedB = 0;
+    clearObservations();
 }
 
 uint8_t SpeedModel::getSpeedA() const {
@@ -0,0 +1,55 @@
+#include "TurnModel.h"
+#include "EEPROMRecord.h"
+
+const uint8_t TURN_MODEL_EEPROM_VERSION = 1;
+const float TURN_MODEL_MIN_RATE = 20.0;    // degrees/s, slower turns coast too little to measure
+const float TURN_MODEL_MAX_COAST_FACTOR = 0.01;     // degrees per (degree/s)^2, 25 degrees of coast at 50 degrees/s
+
+TurnModel::TurnModel(uint8_t min_power, uint8_t max_power, float power_per_degree, float coast_factor, float learning_rate)
+    :   _minPower(min_power),
+        _maxPower(max_power),
+        _powerPerDegree(power_per_degree),
+        _coastFactor(coast_factor),
+        _learningRate(learning_rate),
+        _changed(false)
+{
+}
+
+TurnModel::~TurnModel() {
+}
+
+uint8_t TurnModel::power(float cutoff_angle) const {
+    if (cutoff_angle <= 0.0) {
+        return _minPower;
+    }
+    return min((float)_maxPower, _minPower + _powerPerDegree*cutoff_angle);
+}
+
+void TurnModel::learn(float rate, float coast_angle) {
+    rate = fabs(rate);
+    if (rate < TURN_MODEL_MIN_RATE) {
+        return;
+    }
+    float observed = constrain(coast_angle/(rate*rate), 0.0, TURN_MODEL_MAX_COAST_FACTOR);
+    _coastFactor += _learningRate*(observed - _coastFactor);
+    _changed = true;
+}
+
+bool TurnModel::load(int address) {
+    float coast_factor;
+    if (!read_eeprom_record(address, TURN_MODEL_EEPROM_VERSION, &coast_factor, sizeof(coast_factor))) {
+        return false;
+    }
+    // NaN fails both comparisons
+    if (!(coast_factor >= 0.0 && coast_factor <= TURN_MODEL_MAX_COAST_FACTOR)) {
+        return false;
+    }
+    _coastFactor = coast_factor;
+    _changed = false;
+    return true;
+}
+
+void TurnModel::save(int address) {
+    write_eeprom_record(address, TURN_MODEL_EEPROM_VERSION, &_coastFactor, sizeof(_coastFactor));
+    _changed = false;
+}
@@ -0,0 +1,77 @@
+#include <util/atomic.h>
+#include "WheelEncoder.h"
+
+#define EDGE_INDEX_MASK (WHEEL_ENCODER_EDGE_BUFFER_SIZE - 1)
+
+WheelEncoder::WheelEncoder(double mm_per_edge)
+    :   _mmPerEdge(mm_per_edge),
+        _count(0),
+        _head(0)
+{
+}
+
+void WheelEncoder::record_edge(uint32_t edge_micros) {
+    _edgeMicros[_head & EDGE_INDEX_MASK] = edge_micros;
+    _count++;
+    _head++;
+}
+
+uint32_t WheelEncoder::count() const {
+    uint8_t head;
+    uint32_t value;
+    do {
+        head = _head;
+        value = _count;
+    } while (head != _head);
+    return value;
+}
+
+void WheelEncoder::reset() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        _count = 0;
+        _head = 0;
+    }
+}
+
+uint8_t WheelEncoder::latest_edges(uint32_t* edges, uint8_t max_edges) const {
+    uint8_t head;
+    uint8_t available;
+    do {
+        head = _head;
+        uint32_t count = _count;
+        available = (count < max_edges) ? count : max_edges;
+        for (uint8_t i = 0; i < available; i++) {
+            edges[i] = _edgeMicros[(uint8_t)(head - 1 - i) & EDGE_INDEX_MASK];
+        }
+    } while (head != _head);
+    return available;
+}
+
+double WheelEncoder::period_to_speed(uint32_t period_micros, uint32_t since_last_edge_micros) const {
+    if (since_last_edge_micros > period_micros) {
+        period_micros = since_last_edge_micros;
+    }
+    if (period_micros == 0 || period_micros > WHEEL_ENCODER_STALL_MICROS) {
+        return 0.0;
+    }
+    return _mmPerEdge*1000000.0/period_micros;
+}
+
+double WheelEncoder::speed(uint32_t now_micros) const {
+    uint32_t edges[2];
+    if (latest_edges(edges, 2) < 2) {
+        return 0.0;
+    }
+    return period_to_speed(edges[0] - edges[1], now_micros - edges[0]);
+}
+
+double WheelEncoder::filtered_speed(uint32_t now_micros) const {
+    uint32_t edges[WHEEL_ENCODER_EDGE_BUFFER_SIZE];
+    uint8_t available = latest_edges(edges, WHEEL_ENCODER_EDGE_BUFFER_SIZE);
+    if (available < 2) {
+        return 0.0;
+    }
+    uint8_t periods = available - 1;
+    uint32_t average_period = (edges[0] - edges[periods] + periods/2)/periods;
+    return period_to_speed(average_period, now_micros - edges[0]);
+}
@@ -0,0 +1,49 @@
+#include "WheelSpeedController.h"
+
+WheelSpeedController::WheelSpeedController(double kp, double ki, double max_correction)
+    :   _controller(kp, ki, 0.0, -max_correction, max_correction),
+        _stallPower(0),
+        _referencePower(255),
+        _referenceSpeed(1.0),
+        _targetSpeed(0.0),
+        _power(0)
+{
+}
+
+WheelSpeedController::~WheelSpeedController() {
+}
+
+void WheelSpeedController::setFeedforward(uint8_t stall_power, uint8_t reference_power, double reference_speed) {
+    _stallPower = stall_power;
+    _referencePower = reference_power;
+    _referenceSpeed = reference_speed;
+}
+
+void WheelSpeedController::setTargetSpeed(double speed) {
+    _targetSpeed = speed;
+    _controller.setSetPoint(speed);
+}
+
+uint8_t WheelSpeedController::feedforward(double speed) const {
+    if (speed <= 0.0 || _referenceSpeed <= 0.0) {
+        return 0;
+    }
+    double power = _stallPower + (double(_referencePower) - _stallPower)*speed/_referenceSpeed;
+    return power > 255.0 ? 255 : (uint8_t)power;
+}
+
+uint8_t WheelSpeedController::update(double measured_speed, unsigned long measurement_millis) {
+    double correction = _controller.update(measured_speed, measurement_millis);
+    if (_targetSpeed <= 0.0) {
+        _power = 0;
+        return _power;
+    }
+    double power = feedforward(_targetSpeed) + correction;
+    _power = power > 255.0 ? 255 : (power < 0.0 ? 0 : (uint8_t)power);
+    return _power;
+}
+
+void WheelSpeedController::reset() {
+    _controller.reset();
+    _power = 0;
+}
@@ -16,10 +16,11 @@ void setup() {
     Serial.begin(250000);
     DataLogger::init();
 
-    sprintf(DataLogger::commonBuffer(), "Kamprath Robot starting up with fimware version %s", AUTO_VERSION);
-    INFO_LOG(DataLogger::commonBuffer());
+    INFO_LOGF("Kamprath Robot starting up with fimware version %s", AUTO_VERSION);
 
     driver = new Driver();
+    // write out the start up messages before the queues are drained by the main loop
+    DataLogger::getInstance()->sync();
 }
 
 void loop() {
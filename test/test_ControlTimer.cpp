@@ -0,0 +1,58 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_ControlTimer.h"
+#include "ControlTimer.h"
+
+static uint32_t sampled_value = 0;
+
+static void sample(ControlTick& tick) {
+    tick.left_wheel_counter = sampled_value;
+}
+
+void test_ControlTimer(void) {
+    ControlTimer timer;
+    ControlTick tick;
+
+    // the hardware timer is not started, so only the simulated interrupts below tick. The period is rounded to the
+    // timer's resolution
+    timer.reset(10002, sample);
+    TEST_ASSERT_FALSE(timer.is_running());
+    TEST_ASSERT_EQUAL_UINT32(10000, timer.period_micros());
+    TEST_ASSERT_FALSE(timer.take_tick(tick));
+
+    // the interrupts are simulated by calling the handler directly
+    sampled_value = 5;
+    timer.handleISR();
+    TEST_ASSERT_TRUE(timer.take_tick(tick));
+    TEST_ASSERT_EQUAL_UINT32(1, tick.count);
+    TEST_ASSERT_EQUAL_UINT32(5, tick.left_wheel_counter);
+    TEST_ASSERT_EQUAL_UINT32(10, timer.tick_millis(tick));
+    TEST_ASSERT_FALSE(timer.take_tick(tick));
+
+    // the time left before the next tick is due, which is none once a period has passed
+    uint32_t left = timer.micros_to_next_tick(tick);
+    TEST_ASSERT_TRUE(left > 0 && left <= 10000);
+    ControlTick late_tick = tick;
+    late_tick.micros = micros() - 20000;
+    TEST_ASSERT_EQUAL_UINT32(0, timer.micros_to_next_tick(late_tick));
+
+    // a busy foreground misses ticks, and only sees the latest
+    sampled_value = 6;
+    timer.handleISR();
+    sampled_value = 7;
+    timer.handleISR();
+    sampled_value = 8;
+    timer.handleISR();
+    TEST_ASSERT_TRUE(timer.take_tick(tick));
+    TEST_ASSERT_EQUAL_UINT32(4, tick.count);
+    TEST_ASSERT_EQUAL_UINT32(8, tick.left_wheel_counter);
+    TEST_ASSERT_EQUAL_UINT32(2, timer.overruns());
+
+    // the simulated ticks come much faster than the period
+    TEST_ASSERT_TRUE(timer.max_jitter_micros() > 9000);
+
+    timer.reset(1000000);
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_TIMER_MAX_PERIOD_MICROS, timer.period_micros());
+    TEST_ASSERT_EQUAL_UINT32(0, timer.overruns());
+    TEST_ASSERT_FALSE(timer.take_tick(tick));
+}
@@ -0,0 +1,6 @@
+#ifndef __TEST_CONTROLTIMER_H__
+#define __TEST_CONTROLTIMER_H__
+
+void test_ControlTimer(void);
+
+#endif // __TEST_CONTROLTIMER_H__
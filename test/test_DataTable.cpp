@@ -72,4 +72,415 @@ void test_DataTable_custom_formatter(void) {
     String csv = ss.to_string();
 
     TEST_ASSERT_EQUAL_STRING("col1,col2,col3\r\n2,2,3\r\n8,5,6\r\n14,8,9\r\n\r\n", csv.c_str());
-}
\ No newline at end of file
+}
+
+// captures the bytes written to it so binary output can be checked
+class ByteStream : public Stream {
+public:
+    uint8_t bytes[128];
+    size_t count;
+
+    ByteStream() : count(0) {}
+
+    virtual int available() override               { return 0; }
+    virtual int read() override                     { return -1; }
+    virtual int peek() override                     { return -1; }
+    virtual size_t write(uint8_t c) override {
+        if (count >= sizeof(bytes)) {
+            return 0;
+        }
+        bytes[count++] = c;
+        return 1;
+    }
+};
+
+void test_DataTable_binary(void) {
+    String column_names[] = {"a", "bc"};
+    DataTable<int32_t> dt(2, column_names);
+
+    dt.append_row(2, int32_t(1), int32_t(-2));
+    dt.append_row(2, int32_t(300), int32_t(4));
+
+    ByteStream bs;
+    dt.write_binary_to_stream(bs);
+
+    const uint8_t expected[] = {
+        'D', 'T', 'B', DATA_TABLE_BINARY_VERSION,
+        0,                                  // flags
+        2,                                  // columns
+        2, 0, 0, 0,                         // rows
+        DATA_COLUMN_INT32, 1, 'a',
+        DATA_COLUMN_INT32, 2, 'b', 'c',
+        0x01, 0x00, 0x00, 0x00,             // 1
+        0xFE, 0xFF, 0xFF, 0xFF,             // -2
+        0x2C, 0x01, 0x00, 0x00,             // 300
+        0x04, 0x00, 0x00, 0x00              // 4
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), bs.count);
+    TEST_ASSERT_EQUAL_MEMORY(expected, bs.bytes, sizeof(expected));
+
+    TEST_ASSERT_EQUAL(DATA_COLUMN_UINT8, data_column_type<uint8_t>());
+    TEST_ASSERT_EQUAL(DATA_COLUMN_INT16, data_column_type<int16_t>());
+    TEST_ASSERT_EQUAL(DATA_COLUMN_FLOAT32, data_column_type<float>());
+}
+
+void test_DataTable_fixed(void) {
+    String column_names[] = {"col1", "col2"};
+    DataTable<int> dt(2, column_names, 2, DATA_TABLE_FIXED);
+
+    TEST_ASSERT_TRUE(dt.append_row(2, 1, 2));
+    TEST_ASSERT_TRUE(dt.append_row(2, 3, 4));
+    TEST_ASSERT_FALSE(dt.append_row(2, 5, 6));
+
+    TEST_ASSERT_EQUAL(2, dt.num_rows());
+    TEST_ASSERT_EQUAL(2, dt.capacity());
+    TEST_ASSERT_EQUAL_UINT32(1, dt.dropped_rows());
+    TEST_ASSERT_EQUAL(4*sizeof(int), dt.bytes_used());
+    TEST_ASSERT_EQUAL(4*sizeof(int), dt.bytes_allocated());
+
+    dt.clear();
+    TEST_ASSERT_EQUAL(0, dt.num_rows());
+    TEST_ASSERT_EQUAL(0, dt.bytes_used());
+    TEST_ASSERT_EQUAL(4*sizeof(int), dt.high_water_mark());
+}
+
+void test_DataTable_ring(void) {
+    String column_names[] = {"col1", "col2"};
+    DataTable<int> dt(2, column_names, 3, DATA_TABLE_RING);
+
+    dt.append_row(2, 1, 2);
+    dt.append_row(2, 3, 4);
+    dt.append_row(2, 5, 6);
+    dt.append_row(2, 7, 8);
+    dt.append_row(2, 9, 10);
+
+    TEST_ASSERT_EQUAL(3, dt.num_rows());
+    TEST_ASSERT_EQUAL_UINT32(2, dt.dropped_rows());
+    TEST_ASSERT_EQUAL(5, dt.value(0, 0));
+    TEST_ASSERT_EQUAL(10, dt.value(2, 1));
+
+    StringStream ss;
+    dt.write_to_stream(ss);
+    TEST_ASSERT_EQUAL_STRING("col1,col2\r\n5,6\r\n7,8\r\n9,10\r\n\r\n", ss.to_string().c_str());
+}
+
+void test_DataTable_append(void) {
+    String column_names[] = {"col1", "col2", "col3"};
+    FixedDataTable<double, 3> dt(column_names, 2);
+
+    // values of mixed types are converted to the table's type
+    uint8_t power = 80;
+    unsigned long timestamp = 123456;
+    TEST_ASSERT_TRUE(dt.append(timestamp, power, 1.5));
+    TEST_ASSERT_TRUE(dt.append(-1, 2L, 0.25f));
+    TEST_ASSERT_TRUE(dt.append(7, 8, 9));
+
+    TEST_ASSERT_EQUAL(3, dt.num_rows());
+    TEST_ASSERT_EQUAL_DOUBLE(123456.0, dt.value(0, 0));
+    TEST_ASSERT_EQUAL_DOUBLE(80.0, dt.value(0, 1));
+    TEST_ASSERT_EQUAL_DOUBLE(1.5, dt.value(0, 2));
+    TEST_ASSERT_EQUAL_DOUBLE(-1.0, dt.value(1, 0));
+    TEST_ASSERT_EQUAL_DOUBLE(0.25, dt.value(1, 2));
+    TEST_ASSERT_EQUAL_DOUBLE(9.0, dt.value(2, 2));
+
+    // the base class version checks the number of values at run time
+    DataTable<int>* base = new DataTable<int>(2, column_names, 2);
+    TEST_ASSERT_TRUE(base->append(1, 2));
+    TEST_ASSERT_FALSE(base->append(1, 2, 3));
+    TEST_ASSERT_EQUAL(1, base->num_rows());
+    delete base;
+}
+
+void test_DataTable_column_types(void) {
+    String column_names[] = {"t", "pwm", "heading"};
+    const DataColumnType column_types[] = {DATA_COLUMN_UINT32, DATA_COLUMN_UINT8, DATA_COLUMN_FLOAT32};
+    FixedDataTable<double, 3> dt(column_names, column_types, 4);
+
+    TEST_ASSERT_EQUAL(9, dt.row_size());
+    TEST_ASSERT_EQUAL(4*9, dt.bytes_allocated());
+    TEST_ASSERT_EQUAL(DATA_COLUMN_UINT8, dt.column_type(1));
+
+    // the timestamp is too large for a 4 byte float, but is stored exactly in its uint32_t column
+    TEST_ASSERT_TRUE(dt.append(uint32_t(16777217), 200, 1.5));
+    TEST_ASSERT_TRUE(dt.append_row(3, 2.0, 3.0, -0.25));
+    TEST_ASSERT_EQUAL(2*9, dt.bytes_used());
+    TEST_ASSERT_EQUAL_DOUBLE(200.0, dt.value(0, 1));
+    TEST_ASSERT_EQUAL_DOUBLE(-0.25, dt.value(1, 2));
+
+    StringStream ss;
+    dt.write_to_stream(ss);
+    TEST_ASSERT_EQUAL_STRING("t,pwm,heading\r\n16777217,200,1.50\r\n2,3,-0.25\r\n\r\n", ss.to_string().c_str());
+
+    ByteStream bs;
+    dt.write_binary_to_stream(bs);
+    const uint8_t expected[] = {
+        'D', 'T', 'B', DATA_TABLE_BINARY_VERSION,
+        0,                                  // flags
+        3,                                  // columns
+        2, 0, 0, 0,                         // rows
+        DATA_COLUMN_UINT32, 1, 't',
+        DATA_COLUMN_UINT8, 3, 'p', 'w', 'm',
+        DATA_COLUMN_FLOAT32, 7, 'h', 'e', 'a', 'd', 'i', 'n', 'g',
+        0x01, 0x00, 0x00, 0x01, 200, 0x00, 0x00, 0xC0, 0x3F,   // 16777217, 200, 1.5
+        0x02, 0x00, 0x00, 0x00, 3, 0x00, 0x00, 0x80, 0xBE      // 2, 3, -0.25
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), bs.count);
+    TEST_ASSERT_EQUAL_MEMORY(expected, bs.bytes, sizeof(expected));
+}
+
+// keeps spilled rows in memory so streaming tables can be tested without an SD card
+class MemorySpill : public DataTableSpill {
+public:
+    uint8_t bytes[256];
+    uint32_t count;
+    int appends;
+
+    MemorySpill() : count(0), appends(0) {}
+
+    virtual bool append(const uint8_t* data, size_t size) override {
+        if (count + size > sizeof(bytes)) {
+            return false;
+        }
+        memcpy(&bytes[count], data, size);
+        count += size;
+        appends++;
+        return true;
+    }
+    virtual bool read(uint32_t offset, uint8_t* data, size_t size) override {
+        if (offset + size > count) {
+            return false;
+        }
+        memcpy(data, &bytes[offset], size);
+        return true;
+    }
+    virtual void clear() override                   { count = 0; }
+};
+
+void test_DataTable_streaming(void) {
+    String column_names[] = {"col1", "col2"};
+    const DataColumnType column_types[] = {DATA_COLUMN_UINT16, DATA_COLUMN_INT8};
+    FixedDataTable<int, 2> dt(column_names, column_types, 5);
+    MemorySpill spill;
+
+    TEST_ASSERT_TRUE(dt.set_spill(&spill));
+    TEST_ASSERT_EQUAL(4, dt.capacity());
+
+    // nothing to spill until a block of 2 rows is full
+    dt.append(1, -1);
+    TEST_ASSERT_FALSE(dt.service());
+    dt.append(2, -2);
+    TEST_ASSERT_TRUE(dt.service());
+    TEST_ASSERT_EQUAL(2, dt.spilled_rows());
+    TEST_ASSERT_EQUAL(6, spill.count);
+
+    // without service() the table spills by itself once both blocks are full
+    for (int i = 3; i <= 9; i++) {
+        TEST_ASSERT_TRUE(dt.append(i, -i));
+    }
+    TEST_ASSERT_EQUAL(9, dt.num_rows());
+    TEST_ASSERT_EQUAL(6, dt.spilled_rows());
+    TEST_ASSERT_EQUAL_UINT32(0, dt.dropped_rows());
+    TEST_ASSERT_EQUAL(3*3, dt.bytes_used());
+    TEST_ASSERT_EQUAL(4*3, dt.high_water_mark());
+
+    // the whole table reads back, from the spill and from memory
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL(i + 1, dt.value(i, 0));
+        TEST_ASSERT_EQUAL(-(i + 1), dt.value(i, 1));
+    }
+    StringStream ss;
+    dt.write_to_stream(ss);
+    TEST_ASSERT_EQUAL_STRING(
+        "col1,col2\r\n1,-1\r\n2,-2\r\n3,-3\r\n4,-4\r\n5,-5\r\n6,-6\r\n7,-7\r\n8,-8\r\n9,-9\r\n\r\n",
+        ss.to_string().c_str()
+    );
+
+    dt.clear();
+    TEST_ASSERT_EQUAL(0, dt.num_rows());
+    TEST_ASSERT_EQUAL(0, spill.count);
+    dt.append(10, -10);
+    TEST_ASSERT_EQUAL(10, dt.value(0, 0));
+}
+
+void test_DataTable_formats(void) {
+    String column_names[] = {"count", "x", "y", "big"};
+    const DataColumnType column_types[] = {DATA_COLUMN_INT16, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_UINT32};
+    const DataColumnFormat formats[] = {{0, false}, {2, true}, {0, false}, {0, false}};
+    FixedDataTable<double, 4> dt(column_names, column_types, 4);
+
+    dt.append(-12, 0.0, 2.5, uint32_t(4000000000UL));
+    dt.append(7, -1.005, -0.4, 0);
+    dt.append(0, 99.999, 1234.6, 1);
+
+    StringStream ss;
+    dt.write_to_stream(ss, formats);
+    TEST_ASSERT_EQUAL_STRING(
+        "count,x,y,big\r\n-12,0,3,4000000000\r\n7,-1.00,-0,0\r\n0,100.00,1235,1\r\n\r\n",
+        ss.to_string().c_str()
+    );
+
+    char buffer[DATA_FORMAT_BUFFER_SIZE];
+    TEST_ASSERT_EQUAL(11, format_data_integer(buffer, INT32_MIN));
+    TEST_ASSERT_EQUAL_STRING("-2147483648", buffer);
+    TEST_ASSERT_EQUAL(4, format_data_fixed(buffer, 3.14159, 2));
+    TEST_ASSERT_EQUAL_STRING("3.14", buffer);
+    format_data_fixed(buffer, 0.000123456, 8);
+    TEST_ASSERT_EQUAL_STRING("0.00012346", buffer);
+    format_data_fixed(buffer, 1e10, 2);
+    TEST_ASSERT_EQUAL_STRING("ovf", buffer);
+}
+
+void test_DataTable_binary_compressed(void) {
+    String column_names[] = {"t", "n", "x"};
+    const DataColumnType column_types[] = {DATA_COLUMN_UINT32, DATA_COLUMN_INT16, DATA_COLUMN_FLOAT32};
+    FixedDataTable<double, 3> dt(column_names, column_types, 4);
+
+    dt.append(1000, -1, 1.0);
+    dt.append(1080, -3, 1.0);
+    dt.append(1160, 62, -2.0);
+
+    ByteStream bs;
+    dt.write_binary_to_stream(bs, true);
+
+    const uint8_t expected[] = {
+        'D', 'T', 'B', DATA_TABLE_BINARY_VERSION,
+        DATA_TABLE_FLAG_DELTA_VARINT,
+        3,                                  // columns
+        3, 0, 0, 0,                         // rows
+        DATA_COLUMN_UINT32, 1, 't',
+        DATA_COLUMN_INT16, 1, 'n',
+        DATA_COLUMN_FLOAT32, 1, 'x',
+        0xD0, 0x0F,                         // +1000 zig-zag encoded is 2000
+        0x01,                               // -1 is 1
+        0x80, 0x80, 0x80, 0xFC, 0x03,       // 1.0 is 0x3F800000
+        0xA0, 0x01,                         // +80 is 160
+        0x03,                               // -2 is 3
+        0x00,                               // the same float
+        0xA0, 0x01,                         // +80
+        0x82, 0x01,                         // +65 is 130
+        0x80, 0x80, 0x80, 0xFC, 0x0F        // 1.0 XOR -2.0 is 0xFF800000
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), bs.count);
+    TEST_ASSERT_EQUAL_MEMORY(expected, bs.bytes, sizeof(expected));
+}
+
+class CountingStream : public Stream {
+public:
+    size_t count;
+
+    CountingStream() : count(0) {}
+
+    virtual int available() override               { return 0; }
+    virtual int read() override                     { return -1; }
+    virtual int peek() override                     { return -1; }
+    virtual size_t write(uint8_t c) override        { count++; return 1; }
+};
+
+void test_DataTable_binary_quantized(void) {
+    String column_names[] = {"n", "x"};
+    const DataColumnType column_types[] = {DATA_COLUMN_INT16, DATA_COLUMN_FLOAT32};
+    const DataColumnFormat formats[] = {{0, false}, {2, true}};
+    FixedDataTable<double, 2> dt(column_names, column_types, 4);
+
+    dt.append(-1, 1.0);
+    dt.append(-3, 1.004);
+    dt.append(62, -2.0);
+    dt.append(0, NAN);
+
+    ByteStream bs;
+    dt.write_binary_to_stream(bs, true, formats);
+
+    const uint8_t expected[] = {
+        'D', 'T', 'B', DATA_TABLE_BINARY_VERSION,
+        DATA_TABLE_FLAG_DELTA_VARINT | DATA_TABLE_FLAG_QUANTIZED,
+        2,                                  // columns
+        4, 0, 0, 0,                         // rows
+        DATA_COLUMN_INT16, 1, 'n', DATA_TABLE_NOT_QUANTIZED,
+        DATA_COLUMN_FLOAT32, 1, 'x', 2,
+        0x01,                               // -1 is 1
+        0xC8, 0x01,                         // 1.00 is 100, zig-zag encoded is 200
+        0x03,                               // -2 is 3
+        0x00,                               // 1.004 rounds to the same 100
+        0x82, 0x01,                         // +65 is 130
+        0xD7, 0x04,                         // -2.00 is -200, -300 from 100 is 599
+        0x7B,                               // -62 is 123
+        0xEF, 0xFC, 0xFF, 0xFF, 0x0F        // nan is INT32_MIN, INT32_MIN + 200 zig-zag encoded is 0xFFFFFC6F
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), bs.count);
+    TEST_ASSERT_EQUAL_MEMORY(expected, bs.bytes, sizeof(expected));
+
+    TEST_ASSERT_EQUAL(-150, quantize_data_value(-1.495, 2));
+    TEST_ASSERT_EQUAL(12346, quantize_data_value(1.23456, 4));
+    TEST_ASSERT_EQUAL(DATA_TABLE_QUANTIZED_INVALID, quantize_data_value(1e10, 2));
+    TEST_ASSERT_EQUAL(DATA_TABLE_QUANTIZED_INVALID, quantize_data_value(INFINITY, 0));
+}
+
+// the columns and formats of the robot's move data table
+const int MOVE_COLUMNS = 21;
+static const DataColumnType MOVE_TYPES[MOVE_COLUMNS] = {
+    DATA_COLUMN_UINT32, DATA_COLUMN_UINT16, DATA_COLUMN_UINT16, DATA_COLUMN_UINT8, DATA_COLUMN_UINT8,
+    DATA_COLUMN_UINT8, DATA_COLUMN_UINT8, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32,
+    DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_UINT16, DATA_COLUMN_FLOAT32,
+    DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32,
+    DATA_COLUMN_FLOAT32
+};
+static const DataColumnFormat MOVE_FORMATS[MOVE_COLUMNS] = {
+    {0, false}, {0, false}, {0, false}, {0, false}, {0, false}, {0, false}, {0, false}, {2, true}, {2, true},
+    {2, true}, {2, true}, {2, true}, {2, true}, {0, false}, {8, true}, {8, true}, {1, true}, {1, true}, {1, true},
+    {2, true}, {2, true}
+};
+
+void test_DataTable_binary_move_rows(void) {
+    const int num_rows = 40;
+    String column_names[MOVE_COLUMNS];
+    FixedDataTable<double, MOVE_COLUMNS> dt(column_names, MOVE_TYPES, num_rows, DATA_TABLE_FIXED);
+
+    // a straight move at 400 mm/s, with a row every 80 ms, 10.2 mm wheel ticks and noisy sensors
+    uint32_t seed = 12345;
+    uint32_t left = 0;
+    uint32_t right = 0;
+    double distance = 0.0;
+    double bearing = 0.0;
+    double heading = 0.0;
+    double integral = 0.0;
+    for (int i = 0; i < num_rows; i++) {
+        seed = seed*1103515245UL + 12345UL;
+        double noise = ((seed >> 16) & 0xFF)/256.0 - 0.5;
+        uint8_t left_delta = 3 + (i & 1);
+        uint8_t right_delta = 3 + ((i >> 1) & 1);
+        left += left_delta;
+        right += right_delta;
+        double forward = (left_delta + right_delta)*5.1;
+        double angle = (right_delta - left_delta)*4.41;
+        distance += forward;
+        bearing += angle;
+        heading += 0.3*noise;
+        integral += 0.0013*noise;
+        double speed = 400.0 + 20.0*noise;
+        dt.append(
+            1000 + 80*i, left, right, left_delta, right_delta, 104 + (i & 3), 100 + ((i >> 2) & 3),
+            forward, distance, angle, forward/(angle*PI/180.0 + 1e-3), bearing, heading, 300,
+            integral, 0.027*noise, speed + 7.0*noise, speed - 5.0*noise, 400.0, 0.9*heading, 0.25 + 0.01*noise
+        );
+    }
+    TEST_ASSERT_EQUAL(num_rows, dt.num_rows());
+
+    CountingStream raw;
+    dt.write_binary_to_stream(raw);
+    CountingStream xor_coded;
+    dt.write_binary_to_stream(xor_coded, true);
+    CountingStream quantized;
+    dt.write_binary_to_stream(quantized, true, MOVE_FORMATS);
+
+    // the headers are about the same size, so compare the rows
+    size_t raw_row = raw.count/num_rows;
+    size_t xor_row = xor_coded.count/num_rows;
+    size_t quantized_row = quantized.count/num_rows;
+    char message[80];
+    snprintf(message, sizeof(message), "bytes per row: raw %u, XOR coded %u, quantized %u",
+        (unsigned)raw_row, (unsigned)xor_row, (unsigned)quantized_row);
+    TEST_MESSAGE(message);
+    // the noise in the sensor values is what is left to code, so the quantized rows are about half the raw size
+    TEST_ASSERT_TRUE(quantized.count*3 < raw.count*2);
+    TEST_ASSERT_TRUE(quantized.count*3 < xor_coded.count*2);
+}
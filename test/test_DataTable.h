@@ -4,5 +4,15 @@
 void test_DataTable(void);
 void test_DataTable_extend(void);
 void test_DataTable_custom_formatter(void);
+void test_DataTable_binary(void);
+void test_DataTable_fixed(void);
+void test_DataTable_ring(void);
+void test_DataTable_append(void);
+void test_DataTable_column_types(void);
+void test_DataTable_streaming(void);
+void test_DataTable_formats(void);
+void test_DataTable_binary_compressed(void);
+void test_DataTable_binary_quantized(void);
+void test_DataTable_binary_move_rows(void);
 
 #endif // __TEST_DATATABLE_H__
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include "test_EEPROMRecord.h"
+#include "EEPROMRecord.h"
+#include "PIDController.h"
+
+void test_EEPROMRecord(void) {
+    const int address = EEPROM_TEST_ADDRESS;
+    PIDGains gains = {3.0, 0.1, 0.3};
+    PIDGains read_gains = {0.0, 0.0, 0.0};
+
+    // a blank EEPROM has no record
+    for (int i = 0; i < (int)sizeof(gains) + EEPROM_RECORD_OVERHEAD; i++) {
+        EEPROM.write(address + i, 0xFF);
+    }
+    TEST_ASSERT_FALSE(read_eeprom_record(address, 1, &read_gains, sizeof(read_gains)));
+
+    write_eeprom_record(address, 1, &gains, sizeof(gains));
+    TEST_ASSERT_TRUE(read_eeprom_record(address, 1, &read_gains, sizeof(read_gains)));
+    TEST_ASSERT_EQUAL_FLOAT(3.0, read_gains.kp);
+    TEST_ASSERT_EQUAL_FLOAT(0.1, read_gains.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.3, read_gains.kd);
+
+    // a record of another version or size is rejected
+    TEST_ASSERT_FALSE(read_eeprom_record(address, 2, &read_gains, sizeof(read_gains)));
+    TEST_ASSERT_FALSE(read_eeprom_record(address, 1, &read_gains, sizeof(read_gains) - 1));
+
+    // as is a corrupted record, which leaves the data alone
+    EEPROM.write(address + 4, EEPROM.read(address + 4) ^ 0x01);
+    read_gains.kp = 7.0;
+    TEST_ASSERT_FALSE(read_eeprom_record(address, 1, &read_gains, sizeof(read_gains)));
+    TEST_ASSERT_EQUAL_FLOAT(7.0, read_gains.kp);
+
+    // and a record that would run past the end of the EEPROM is rejected
+    TEST_ASSERT_FALSE(read_eeprom_record(EEPROM.length() - 4, 1, &read_gains, sizeof(read_gains)));
+}
@@ -0,0 +1,6 @@
+#ifndef __TEST_EEPROMRECORD_H__
+#define __TEST_EEPROMRECORD_H__
+
+void test_EEPROMRecord(void);
+
+#endif // __TEST_EEPROMRECORD_H__
@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_FixedPoint.h"
+#include "test_odometry_reference.h"
+#include "FixedPoint.h"
+#include "Odometry.h"
+
+void test_FixedPoint_math(void) {
+    TEST_ASSERT_EQUAL_INT32(65536, Q16(1.0));
+    TEST_ASSERT_EQUAL_INT32(-98304, Q16(-1.5));
+    TEST_ASSERT_EQUAL_INT32(Q16(3.0), q16_from_int(3));
+    TEST_ASSERT_EQUAL_DOUBLE(-2.25, q16_to_double(Q16(-2.25)));
+
+    TEST_ASSERT_EQUAL_INT32(Q16(3.75), q16_mul(Q16(1.5), Q16(2.5)));
+    TEST_ASSERT_EQUAL_INT32(Q16(-3.75), q16_mul(Q16(-1.5), Q16(2.5)));
+    // the product is formed in 64 bits, so large values do not overflow before the shift
+    TEST_ASSERT_EQUAL_INT32(Q16(20000.0), q16_mul(Q16(10000.0), Q16(2.0)));
+}
+
+void test_FixedPoint_sin_cos(void) {
+    // sweep several turns in both directions, at a step that does not line up with the table
+    double max_error = 0.0;
+    for (double angle = -4.0*PI; angle <= 4.0*PI; angle += 0.0123) {
+        q16_t q_angle = q16_from_double(angle);
+        double exact_angle = q16_to_double(q_angle);
+        double sin_error = fabs(q16_to_double(q16_sin(q_angle)) - sin(exact_angle));
+        double cos_error = fabs(q16_to_double(q16_cos(q_angle)) - cos(exact_angle));
+        max_error = max(max_error, max(sin_error, cos_error));
+    }
+    TEST_ASSERT_TRUE(max_error < 3.0/65536.0);
+
+    TEST_ASSERT_EQUAL_INT32(0, q16_sin(0));
+    TEST_ASSERT_EQUAL_INT32(Q16_ONE, q16_sin(Q16_HALF_PI));
+    TEST_ASSERT_EQUAL_INT32(-Q16_ONE, q16_sin(-Q16_HALF_PI));
+    TEST_ASSERT_INT_WITHIN(1, -Q16_ONE, q16_cos(Q16_PI));
+}
+
+void test_FixedOdometry(void) {
+    FixedOdometry odometry(ODOMETRY_WHEEL_CIRCUMFERENCE, ODOMETRY_DISC_HOLE_COUNT, ODOMETRY_WHEEL_BASE);
+    OdometryStep step;
+
+    // driving straight is just the wheel distance
+    odometry.step(5, 5, step);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 5*214.0/20, q16_to_double(step.forward));
+    TEST_ASSERT_EQUAL_INT32(0, step.lateral);
+    TEST_ASSERT_EQUAL_INT32(0, step.angle);
+
+    // compare against the floating point calculation over the wheel counter deltas of a telemetry step, and beyond
+    double max_forward_error = 0.0;
+    double max_lateral_error = 0.0;
+    double max_angle_error = 0.0;
+    double max_radius_error = 0.0;
+    for (uint16_t left = 0; left <= 40; left++) {
+        for (uint16_t right = 0; right <= 40; right++) {
+            ReferenceOdometryStep expected;
+            reference_odometry_step(left, right, expected);
+            odometry.step(left, right, step);
+            max_forward_error = max(max_forward_error, fabs(q16_to_double(step.forward) - expected.forward));
+            max_lateral_error = max(max_lateral_error, fabs(q16_to_double(step.lateral) - expected.lateral));
+            max_angle_error = max(max_angle_error, fabs(q16_to_double(step.angle) - expected.angle));
+            max_radius_error = max(max_radius_error, fabs(q16_to_double(step.radius) - expected.radius));
+        }
+    }
+    // the AVR printf has no floating point, so the errors are reported in micrometers and microradians
+    char message[120];
+    snprintf(
+        message,
+        sizeof(message),
+        "FixedOdometry max errors: forward %lu um, lateral %lu um, angle %lu urad, radius %lu um",
+        (unsigned long)(max_forward_error*1000.0),
+        (unsigned long)(max_lateral_error*1000.0),
+        (unsigned long)(max_angle_error*1000000.0),
+        (unsigned long)(max_radius_error*1000.0)
+    );
+    TEST_MESSAGE(message);
+    // the distance errors grow with the turning radius, as the sine error is multiplied by it. They stay far below the
+    // 10.7 mm a wheel moves per tick
+    TEST_ASSERT_TRUE(max_forward_error < 0.2);
+    TEST_ASSERT_TRUE(max_lateral_error < 0.2);
+    TEST_ASSERT_TRUE(max_angle_error < 0.00001);
+    TEST_ASSERT_TRUE(max_radius_error < 0.001);
+}
@@ -0,0 +1,8 @@
+#ifndef __TEST_FIXEDPOINT_H__
+#define __TEST_FIXEDPOINT_H__
+
+void test_FixedPoint_math(void);
+void test_FixedPoint_sin_cos(void);
+void test_FixedOdometry(void);
+
+#endif // __TEST_FIXEDPOINT_H__
@@ -0,0 +1,51 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_HeadingFilter.h"
+#include "HeadingFilter.h"
+
+void test_HeadingFilter(void) {
+    HeadingFilter filter(0.5, 2.0, 0.0);
+
+    // the prediction follows the gyro, and the variance grows with time
+    filter.reset(10.0);
+    filter.predict(15.0, 1.0);
+    TEST_ASSERT_EQUAL_FLOAT(15.0, filter.getHeading());
+    TEST_ASSERT_EQUAL_FLOAT(0.5, filter.getVariance());
+    filter.predict(20.0, 1.5);
+    TEST_ASSERT_EQUAL_FLOAT(20.0, filter.getHeading());
+    TEST_ASSERT_EQUAL_FLOAT(1.25, filter.getVariance());
+
+    // the correction moves towards the wheel heading by the Kalman gain, 1.25/(1.25 + 2.0), and shrinks the variance
+    filter.correct(30.0, 0.0);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 20.0 + 10.0*1.25/3.25, filter.getHeading());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 1.25*2.0/3.25, filter.getVariance());
+
+    // right after a reset the heading is exact, so the wheels can not move it
+    filter.reset();
+    filter.correct(5.0, 100.0);
+    TEST_ASSERT_EQUAL_FLOAT(0.0, filter.getHeading());
+    TEST_ASSERT_EQUAL_FLOAT(0.0, filter.getVariance());
+}
+
+void test_HeadingFilter_drift(void) {
+    HeadingFilter filter(0.5, 1.8, 0.005);
+
+    // a straight 2 m drive over 5 s, with a gyro that drifts 2 degrees/s, and wheels whose heading is quantized to
+    // 4.6 degree steps, but is right on average
+    filter.reset();
+    float gyro = 0.0;
+    float distance = 0.0;
+    for (int i = 1; i <= 500; i++) {
+        gyro += 0.02;
+        distance += 4.0;
+        filter.predict(gyro, 0.01);
+        float wheel = (i % 50 < 25) ? 0.0 : 4.6;
+        filter.correct(wheel - 2.3, distance);
+    }
+    // the gyro alone is 10 degrees off, the fused heading much less
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 10.0, gyro);
+    TEST_ASSERT_TRUE(fabs(filter.getHeading()) < 3.0);
+    // and the filter knows it is less certain than right after the start
+    TEST_ASSERT_TRUE(filter.getVariance() > 0.0);
+    TEST_ASSERT_TRUE(filter.getVariance() < 1.8 + 0.005*distance);
+}
@@ -0,0 +1,7 @@
+#ifndef __TEST_HEADINGFILTER_H__
+#define __TEST_HEADINGFILTER_H__
+
+void test_HeadingFilter(void);
+void test_HeadingFilter_drift(void);
+
+#endif // __TEST_HEADINGFILTER_H__
@@ -0,0 +1,71 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_LogEvent.h"
+#include "LogEvent.h"
+
+void test_LogEventRecord(void) {
+    LogEventRecord record(1, 0x0102, 0x0A0B0C0D, (int8_t)-1, (uint16_t)500, 1.5f, "ab");
+
+    const uint8_t expected[] = {
+        LOG_EVENT_MARKER,
+        1,                                  // level
+        0x02, 0x01,                         // event ID
+        0x0D, 0x0C, 0x0B, 0x0A,             // timestamp
+        14,                                 // payload length
+        DATA_COLUMN_INT8, 0xFF,
+        DATA_COLUMN_UINT16, 0xF4, 0x01,
+        DATA_COLUMN_FLOAT32, 0x00, 0x00, 0xC0, 0x3F,
+        LOG_EVENT_ARG_STRING, 2, 'a', 'b'
+    };
+    TEST_ASSERT_FALSE(record.truncated());
+    TEST_ASSERT_EQUAL(sizeof(expected), record.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, record.data(), sizeof(expected));
+}
+
+void test_LogEventRecord_truncated(void) {
+    const char* long_string = "0123456789012345678901234567890123456789012345678901234567890123456789";
+    LogEventRecord record(0, 1, 0, (uint8_t)7, long_string, (uint8_t)8);
+
+    // the string does not fit, so it and every argument after it is dropped
+    TEST_ASSERT_TRUE(record.truncated());
+    TEST_ASSERT_EQUAL(LOG_EVENT_HEADER_SIZE + 2, record.size());
+    TEST_ASSERT_EQUAL(2, record.data()[8]);
+}
+
+class CaptureStream : public Print {
+public:
+    uint8_t bytes[160];
+    size_t count;
+
+    CaptureStream() : count(0) {}
+
+    virtual size_t write(uint8_t c) override {
+        if (count >= sizeof(bytes)) {
+            return 0;
+        }
+        bytes[count++] = c;
+        return 1;
+    }
+    using Print::write;
+};
+
+void test_LogFrameStream(void) {
+    CaptureStream capture;
+    LogFrameStream frames(capture);
+    for (int i = 0; i < LOG_FRAME_MAX_SIZE + 2; i++) {
+        frames.write((uint8_t)(LOG_EVENT_MARKER + i));
+    }
+    // a full frame is written as soon as it is full
+    TEST_ASSERT_EQUAL(2 + LOG_FRAME_MAX_SIZE, capture.count);
+    TEST_ASSERT_EQUAL(LOG_FRAME_MARKER, capture.bytes[0]);
+    TEST_ASSERT_EQUAL(LOG_FRAME_MAX_SIZE, capture.bytes[1]);
+    TEST_ASSERT_EQUAL(LOG_EVENT_MARKER, capture.bytes[2]);
+
+    frames.finish();
+    const uint8_t expected_end[] = {
+        LOG_FRAME_MARKER, 2, (uint8_t)(LOG_EVENT_MARKER + LOG_FRAME_MAX_SIZE),
+        (uint8_t)(LOG_EVENT_MARKER + LOG_FRAME_MAX_SIZE + 1), LOG_FRAME_MARKER, 0
+    };
+    TEST_ASSERT_EQUAL(2 + LOG_FRAME_MAX_SIZE + sizeof(expected_end), capture.count);
+    TEST_ASSERT_EQUAL_MEMORY(expected_end, &capture.bytes[2 + LOG_FRAME_MAX_SIZE], sizeof(expected_end));
+}
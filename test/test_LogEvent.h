@@ -0,0 +1,8 @@
+#ifndef __TEST_LOGEVENT_H__
+#define __TEST_LOGEVENT_H__
+
+void test_LogEventRecord(void);
+void test_LogEventRecord_truncated(void);
+void test_LogFrameStream(void);
+
+#endif // __TEST_LOGEVENT_H__
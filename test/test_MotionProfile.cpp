@@ -0,0 +1,62 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_MotionProfile.h"
+#include "MotionProfile.h"
+
+// drives a simulated robot that follows the commanded speed exactly, and returns the peak speed
+static double run_profile(MotionProfile& profile, double distance, double dt, double& time, double& last_speed) {
+    double travelled = 0.0;
+    double peak = 0.0;
+    time = 0.0;
+    last_speed = 0.0;
+    profile.start(distance);
+    while (time < 100.0) {
+        double speed = profile.update(travelled, dt);
+        if (speed == 0.0) {
+            break;
+        }
+        last_speed = speed;
+        if (speed > peak) {
+            peak = speed;
+        }
+        travelled += speed*dt;
+        time += dt;
+    }
+    return peak;
+}
+
+void test_MotionProfile(void) {
+    MotionProfile profile(800.0, 400.0, 600.0, 60.0);
+
+    // the first step is at least the final speed, so the move starts
+    profile.start(1000.0);
+    TEST_ASSERT_EQUAL_DOUBLE(60.0, profile.update(0.0, 0.01));
+    // then the speed ramps up at the acceleration
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 68.0, profile.update(0.6, 0.01));
+    // and the ramp-down is planned from the remaining distance
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, sqrt(60.0*60.0 + 2.0*600.0*10.0), profile.stoppingSpeed(10.0));
+
+    double time;
+    double last_speed;
+    double peak = run_profile(profile, 1000.0, 0.01, time, last_speed);
+    TEST_ASSERT_EQUAL_DOUBLE(400.0, peak);
+    // the move ends at the final speed. A constant 400 mm/s would take 2.5 s, the ramps add about 0.55 s
+    TEST_ASSERT_DOUBLE_WITHIN(5.0, 60.0, last_speed);
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, 3.0, time);
+
+    // past the end the profile commands a stop
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, profile.update(1000.5, 0.01));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, profile.getSpeed());
+}
+
+void test_MotionProfile_short(void) {
+    MotionProfile profile(800.0, 400.0, 600.0, 60.0);
+
+    // a move too short for the cruise speed is a triangle
+    double time;
+    double last_speed;
+    double peak = run_profile(profile, 100.0, 0.01, time, last_speed);
+    TEST_ASSERT_TRUE(peak < 400.0);
+    TEST_ASSERT_TRUE(peak > 200.0);
+    TEST_ASSERT_DOUBLE_WITHIN(5.0, 60.0, last_speed);
+}
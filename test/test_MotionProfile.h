@@ -0,0 +1,7 @@
+#ifndef __TEST_MOTIONPROFILE_H__
+#define __TEST_MOTIONPROFILE_H__
+
+void test_MotionProfile(void);
+void test_MotionProfile_short(void);
+
+#endif // __TEST_MOTIONPROFILE_H__
@@ -0,0 +1,98 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_PIDController.h"
+#include "PIDController.h"
+
+void test_PIDController(void) {
+    PIDController controller(2.0, 1.0, 0.0, -100, 100);
+    controller.setSetPoint(10.0);
+
+    // the first update only starts the clock
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, controller.update(4.0, 1000));
+
+    // P = 2*6, I = 1*6*0.5
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, 15.0, controller.update(4.0, 1500));
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, 3.0, controller.getIntegralTerm());
+
+    // a repeated time does not divide by a zero time step, and gives the last output again
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, 15.0, controller.update(8.0, 1500));
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, 3.0, controller.getIntegralTerm());
+
+    // with a setpoint weight of 0.5 the proportional term is 2*(0.5*10 - 4), the integral still uses the full error
+    controller.setSetPointWeight(0.5);
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, 2.0 + 3.0 + 3.0, controller.update(4.0, 2000));
+
+    controller.reset();
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, controller.getIntegralTerm());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, controller.update(4.0, 3000));
+}
+
+void test_PIDController_anti_windup(void) {
+    // with the output stuck at the limit, the clamped integral stops growing
+    PIDController clamped(1.0, 10.0, 0.0, -5, 5);
+    clamped.setSetPoint(100.0);
+    clamped.update(0.0, 0);
+    for (unsigned long t = 10; t <= 1000; t += 10) {
+        TEST_ASSERT_EQUAL_DOUBLE(5.0, clamped.update(0.0, t));
+    }
+    TEST_ASSERT_TRUE(clamped.getIntegralTerm() < 10.0);
+
+    // so the output comes off the limit as soon as the error changes sign
+    TEST_ASSERT_TRUE(clamped.update(110.0, 1010) < 0.0);
+
+    // back calculation pulls the integral back towards the limit instead
+    PIDController tracking(1.0, 10.0, 0.0, -5, 5);
+    tracking.setAntiWindup(PID_ANTI_WINDUP_BACK_CALCULATION, 20.0);
+    tracking.setSetPoint(1.0);
+    tracking.update(0.0, 0);
+    for (unsigned long t = 10; t <= 5000; t += 10) {
+        tracking.update(0.0, t);
+    }
+    // it settles where each step's integral growth, ki*error*dt = 0.1, is balanced by the pull back,
+    // tracking_gain*excess*dt, so the signal, which includes the step's growth, exceeds the limit by 0.5
+    double excess = 1.0 + tracking.getIntegralTerm() + 0.1 - 5.0;
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.5, excess);
+
+    // without anti-windup the integral would be 10*1*5 = 50
+    TEST_ASSERT_TRUE(tracking.getIntegralTerm() < 5.0);
+}
+
+void test_PIDController_derivative(void) {
+    PIDController controller(0.0, 0.0, 1.0, -1000, 1000);
+    controller.setSetPoint(0.0);
+    controller.update(0.0, 0);
+
+    // a setpoint change does not kick the derivative, which acts on the measurement
+    controller.setSetPoint(50.0);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, controller.update(0.0, 10));
+
+    // a rising measurement pushes the output down, at the measurement's rate
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, -100.0, controller.update(1.0, 20));
+
+    // the filter smooths a step in the rate
+    PIDController filtered(0.0, 0.0, 1.0, -1000, 1000);
+    filtered.setDerivativeFilter(0.25);
+    filtered.update(0.0, 0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, -25.0, filtered.update(1.0, 10));
+    TEST_ASSERT_DOUBLE_WITHIN(0.0001, -43.75, filtered.update(2.0, 20));
+}
+
+void test_PIDController_fixed_point(void) {
+    // the fixed point controller follows the floating point one
+    PIDController reference(3.0, 0.1, 0.3, -30, 30);
+    FixedPIDController fixed(3.0, 0.1, 0.3, -30, 30);
+    reference.setDerivativeFilter(0.3);
+    fixed.setDerivativeFilter(0.3);
+    reference.setSetPoint(0.0);
+    fixed.setSetPoint(0.0);
+
+    double max_error = 0.0;
+    for (unsigned long t = 0; t <= 3000; t += 10) {
+        double heading = 8.0*sin(t/400.0) + 0.5;
+        double expected = reference.update(heading, t);
+        double actual = q16_to_double(fixed.update(q16_from_double(heading), t));
+        max_error = max(max_error, fabs(actual - expected));
+    }
+    TEST_ASSERT_TRUE(max_error < 0.01);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, reference.getIntegralTerm(), q16_to_double(fixed.getIntegralTerm()));
+}
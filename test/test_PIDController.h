@@ -0,0 +1,9 @@
+#ifndef __TEST_PIDCONTROLLER_H__
+#define __TEST_PIDCONTROLLER_H__
+
+void test_PIDController(void);
+void test_PIDController_anti_windup(void);
+void test_PIDController_derivative(void);
+void test_PIDController_fixed_point(void);
+
+#endif // __TEST_PIDCONTROLLER_H__
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_PoseEstimator.h"
+#include "PoseEstimator.h"
+
+static OdometryStep make_step(double forward, double lateral) {
+    OdometryStep step;
+    step.forward = q16_from_double(forward);
+    step.lateral = q16_from_double(lateral);
+    step.angle = 0;
+    step.radius = 0;
+    return step;
+}
+
+void test_PoseEstimator(void) {
+    PoseEstimator pose(8);
+
+    // forward is along y
+    pose.update(make_step(100.0, 0.0), 0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.0, pose.x());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 100.0, pose.y());
+
+    // a turn to the left points the robot towards negative x, the way Point::absolute_bearing() does
+    pose.rotate(Q16_HALF_PI);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 90.0, pose.heading());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, Point(0, 100).absolute_bearing(Point(-50, 100)), pose.heading());
+    pose.update(make_step(50.0, 0.0), 0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, -50.0, pose.x());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 100.0, pose.y());
+
+    // lateral motion is to the left of the heading, which is now back along negative y
+    pose.update(make_step(0.0, 10.0), 0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, -50.0, pose.x());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 90.0, pose.y());
+
+    // the heading wraps at 180 degrees
+    pose.rotate(Q16_PI);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, -90.0, pose.heading());
+    pose.update(make_step(50.0, 0.0), Q16_HALF_PI);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.0, pose.x());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 90.0, pose.y());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.0, pose.heading());
+
+    pose.reset(10.0, 20.0, -45.0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 10.0, pose.x());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 20.0, pose.y());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, -45.0, pose.heading());
+    TEST_ASSERT_EQUAL(10, pose.position().x());
+}
+
+void test_PoseEstimator_trajectory(void) {
+    PoseEstimator pose(4);
+
+    // the trajectory keeps the most recent poses
+    for (int i = 1; i <= 6; i++) {
+        pose.update(make_step(10.0, 0.0), 0);
+        pose.record(i*80);
+    }
+    const DataTable<double>& trajectory = pose.trajectory();
+    TEST_ASSERT_EQUAL(4, trajectory.num_rows());
+    TEST_ASSERT_EQUAL(POSE_TRAJECTORY_COLUMNS, trajectory.num_columns());
+    TEST_ASSERT_EQUAL_DOUBLE(240.0, trajectory.value(0, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 30.0, trajectory.value(0, 2));
+    TEST_ASSERT_EQUAL_DOUBLE(480.0, trajectory.value(3, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 60.0, trajectory.value(3, 2));
+
+    pose.reset();
+    TEST_ASSERT_EQUAL(0, pose.trajectory().num_rows());
+}
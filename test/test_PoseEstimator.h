@@ -0,0 +1,7 @@
+#ifndef __TEST_POSEESTIMATOR_H__
+#define __TEST_POSEESTIMATOR_H__
+
+void test_PoseEstimator(void);
+void test_PoseEstimator_trajectory(void);
+
+#endif // __TEST_POSEESTIMATOR_H__
@@ -0,0 +1,75 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_PurePursuit.h"
+#include "PurePursuit.h"
+
+void test_PurePursuit(void) {
+    PurePursuit pursuit(200.0, 400.0, 60.0, 600.0, 300.0);
+    PointSequence path;
+    path.add(0, 0);
+    path.add(0, 2000);
+    pursuit.start(path);
+    PursuitCommand command;
+
+    // on the path and facing along it, the robot drives straight at the cruise speed
+    TEST_ASSERT_TRUE(pursuit.update(0.0, 500.0, 0.0, command));
+    TEST_ASSERT_FLOAT_WITHIN(0.00001, 0.0, command.curvature);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 400.0, command.speed);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1500.0, command.remaining);
+
+    // to the right of the path it turns left, to the left of it it turns right
+    TEST_ASSERT_TRUE(pursuit.update(50.0, 500.0, 0.0, command));
+    TEST_ASSERT_TRUE(command.curvature > 0.0);
+    TEST_ASSERT_TRUE(pursuit.update(-50.0, 500.0, 0.0, command));
+    TEST_ASSERT_TRUE(command.curvature < 0.0);
+
+    // the arc passes through the lookahead point: 200 mm ahead on the path, from 50 mm to its right
+    TEST_ASSERT_TRUE(pursuit.update(50.0, 500.0, 0.0, command));
+    float distance = sqrt(50.0*50.0 + 200.0*200.0);
+    TEST_ASSERT_FLOAT_WITHIN(0.00001, 2.0*(50.0/distance)/distance, command.curvature);
+
+    // it slows down towards the final speed at the end, and is then complete
+    TEST_ASSERT_TRUE(pursuit.update(0.0, 1980.0, 0.0, command));
+    TEST_ASSERT_FLOAT_WITHIN(0.1, sqrt(60.0*60.0 + 2.0*600.0*20.0), command.speed);
+    TEST_ASSERT_FALSE(pursuit.update(0.0, 1995.0, 0.0, command));
+    TEST_ASSERT_TRUE(pursuit.is_complete());
+}
+
+void test_PurePursuit_path(void) {
+    // the path the driver's button drives, followed by an ideal robot that drives exactly the commanded arc
+    PurePursuit pursuit(200.0, 400.0, 60.0, 600.0, 300.0);
+    PointSequence path;
+    path.add(0, 0);
+    path.add(0, 1500);
+    path.add(-250, 1500);
+    path.add(-250, 1000);
+    path.add(0, 1000);
+    path.add(0, 0);
+    pursuit.start(path);
+
+    const float dt = 0.02;
+    float x = 0.0;
+    float y = 0.0;
+    float heading = 0.0;
+    float time = 0.0;
+    float max_corner_speed = 0.0;       // on the 250 mm segment between the first two corners
+    PursuitCommand command;
+    while (pursuit.update(x, y, heading, command) && time < 60.0) {
+        if (pursuit.segment() == 1) {
+            max_corner_speed = max(max_corner_speed, command.speed);
+        }
+        heading += command.speed*command.curvature*dt*(180.0/PI);
+        x -= command.speed*dt*sin(heading*(PI/180.0));
+        y += command.speed*dt*cos(heading*(PI/180.0));
+        time += dt;
+    }
+    TEST_ASSERT_TRUE(pursuit.is_complete());
+
+    // it ends at the end of the path, having taken the corners at the speed for their arcs
+    TEST_ASSERT_FLOAT_WITHIN(20.0, 0.0, x);
+    TEST_ASSERT_FLOAT_WITHIN(20.0, 0.0, y);
+    TEST_ASSERT_TRUE(max_corner_speed < 300.0);
+
+    // the path is 3500 mm long, and it is driven without stopping
+    TEST_ASSERT_TRUE(time < 14.0);
+}
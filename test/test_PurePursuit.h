@@ -0,0 +1,7 @@
+#ifndef __TEST_PUREPURSUIT_H__
+#define __TEST_PUREPURSUIT_H__
+
+void test_PurePursuit(void);
+void test_PurePursuit_path(void);
+
+#endif // __TEST_PUREPURSUIT_H__
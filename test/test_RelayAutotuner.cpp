@@ -0,0 +1,61 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_RelayAutotuner.h"
+#include "RelayAutotuner.h"
+
+void test_RelayAutotuner(void) {
+    // an integrating loop with a dead time, like the heading: it turns at 20 degrees/s per unit of output, 100 ms late
+    const double rate = 20.0;
+    const int delay_steps = 10;
+    double delayed[delay_steps] = {0};
+    double heading = -1.0;
+
+    RelayAutotuner autotuner(2.0, 0.5, 4, 5000);
+    autotuner.start(0.0, 0);
+    TEST_ASSERT_EQUAL(AUTOTUNE_RUNNING, autotuner.state());
+    unsigned long t = 0;
+    while (autotuner.is_running() && t < 10000) {
+        t += 10;
+        double output = autotuner.update(heading, t);
+        heading += rate*delayed[t/10 % delay_steps]*0.01;
+        delayed[t/10 % delay_steps] = output;
+    }
+    TEST_ASSERT_EQUAL(AUTOTUNE_COMPLETE, autotuner.state());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, autotuner.update(heading, t + 10));
+
+    // the heading ramps at 40 degrees/s, so it takes 12.5 ms past the hysteresis and another 100 ms of dead time to
+    // turn around: the oscillation has an amplitude of 4.5 degrees and a period of 4*(12.5 + 100) ms
+    TEST_ASSERT_DOUBLE_WITHIN(0.03, 0.45, autotuner.ultimatePeriod());
+    double expected_gain = 4.0*2.0/(PI*sqrt(4.5*4.5 - 0.5*0.5));
+    TEST_ASSERT_DOUBLE_WITHIN(0.05, expected_gain, autotuner.ultimateGain());
+
+    PIDGains gains = autotuner.gains();
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, autotuner.ultimateGain()/2.2, gains.kp);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, gains.kp/(2.2*autotuner.ultimatePeriod()), gains.ki);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, gains.kp*autotuner.ultimatePeriod()/6.3, gains.kd);
+}
+
+void test_RelayAutotuner_timeout(void) {
+    // a loop that never crosses the set point fails once the time is up
+    RelayAutotuner autotuner(2.0, 0.5, 4, 1000);
+    autotuner.start(0.0, 500);
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, autotuner.update(-5.0, 500));
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, autotuner.update(-5.0, 1500));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, autotuner.update(-5.0, 1510));
+    TEST_ASSERT_EQUAL(AUTOTUNE_FAILED, autotuner.state());
+
+    // measurement times on a clock restarted after the start, as the control tick times are, do not time out at once
+    autotuner.start(0.0, 4000000);
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, autotuner.update(-5.0, 0));
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, autotuner.update(-5.0, 1000));
+    TEST_ASSERT_EQUAL(AUTOTUNE_RUNNING, autotuner.state());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, autotuner.update(-5.0, 1010));
+    TEST_ASSERT_EQUAL(AUTOTUNE_FAILED, autotuner.state());
+
+    // stopping a running experiment fails it too
+    autotuner.start(0.0, 0);
+    autotuner.update(1.0, 10);
+    autotuner.stop();
+    TEST_ASSERT_EQUAL(AUTOTUNE_FAILED, autotuner.state());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, autotuner.update(1.0, 20));
+}
@@ -0,0 +1,7 @@
+#ifndef __TEST_RELAYAUTOTUNER_H__
+#define __TEST_RELAYAUTOTUNER_H__
+
+void test_RelayAutotuner(void);
+void test_RelayAutotuner_timeout(void);
+
+#endif // __TEST_RELAYAUTOTUNER_H__
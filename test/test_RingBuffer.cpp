@@ -0,0 +1,50 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_RingBuffer.h"
+#include "RingBuffer.h"
+
+void test_RingBuffer(void) {
+    RingBuffer<8> rb;
+
+    TEST_ASSERT_EQUAL_UINT16(0, rb.size());
+    TEST_ASSERT_EQUAL_UINT16(8, rb.capacity());
+    TEST_ASSERT_TRUE(rb.is_empty());
+    TEST_ASSERT_EQUAL(-1, rb.read());
+
+    rb.print("abc");
+    TEST_ASSERT_EQUAL_UINT16(3, rb.size());
+    TEST_ASSERT_EQUAL_UINT16(5, rb.free_space());
+    TEST_ASSERT_EQUAL('a', rb.peek());
+    TEST_ASSERT_EQUAL('a', rb.read());
+    TEST_ASSERT_EQUAL('b', rb.read());
+    TEST_ASSERT_EQUAL_UINT16(1, rb.size());
+
+    // overfill the buffer. Only 7 of the 10 bytes fit.
+    rb.print("0123456789");
+    TEST_ASSERT_TRUE(rb.is_full());
+    TEST_ASSERT_EQUAL_UINT32(3, rb.dropped_bytes());
+
+    rb.clear();
+    TEST_ASSERT_TRUE(rb.is_empty());
+    TEST_ASSERT_EQUAL_UINT32(3, rb.dropped_bytes());
+}
+
+void test_RingBuffer_wrap(void) {
+    RingBuffer<8> rb;
+
+    rb.print("abcdef");
+    rb.consume(4);
+    rb.print("ghijkl");
+    TEST_ASSERT_EQUAL_UINT16(8, rb.size());
+    TEST_ASSERT_EQUAL_UINT32(0, rb.dropped_bytes());
+
+    // the data wraps around the end of the storage, so it is read in two contiguous chunks
+    TEST_ASSERT_EQUAL_UINT16(4, rb.contiguous_size());
+    TEST_ASSERT_EQUAL_MEMORY("efgh", rb.read_pointer(), 4);
+    rb.consume(4);
+    TEST_ASSERT_EQUAL_UINT16(4, rb.contiguous_size());
+    TEST_ASSERT_EQUAL_MEMORY("ijkl", rb.read_pointer(), 4);
+    rb.consume(10);
+    TEST_ASSERT_TRUE(rb.is_empty());
+    TEST_ASSERT_EQUAL_UINT16(0, rb.contiguous_size());
+}
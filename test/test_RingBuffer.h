@@ -0,0 +1,7 @@
+#ifndef __TEST_RINGBUFFER_H__
+#define __TEST_RINGBUFFER_H__
+
+void test_RingBuffer(void);
+void test_RingBuffer_wrap(void);
+
+#endif // __TEST_RINGBUFFER_H__
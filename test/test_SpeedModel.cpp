@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_SpeedModel.h"
+#include "SpeedModel.h"
+#include "EEPROMRecord.h"
+
+void test_SpeedModel(void) {
+    SpeedModel model;
+
+    // on a table power level the measured ratio is used as is
+    model.setAverageSpeed(100);
+    TEST_ASSERT_EQUAL_UINT8(100, model.getSpeedA());
+    TEST_ASSERT_EQUAL_UINT8((int)(100*0.99218), model.getSpeedB());
+
+    // between levels it is interpolated
+    model.setAverageSpeed(150);
+    TEST_ASSERT_EQUAL_UINT8(150, model.getSpeedA());
+    TEST_ASSERT_EQUAL_UINT8((int)(150*(1.00608 + 0.99909)/2), model.getSpeedB());
+
+    // and below the table the power is raised to the lowest level
+    model.setAverageSpeed(20);
+    TEST_ASSERT_EQUAL_UINT8(70, model.getSpeedA());
+    TEST_ASSERT_EQUAL_UINT8((int)(70*1.00467), model.getSpeedB());
+
+    // at full power the right motor is held back the most
+    model.setAverageSpeed(255);
+    TEST_ASSERT_EQUAL_UINT8(255, model.getSpeedA());
+    TEST_ASSERT_EQUAL_UINT8((int)(255*0.87813), model.getSpeedB());
+}
+
+void test_SpeedModel_learning(void) {
+    SpeedModel model;
+    float initial_ratio = model.getRatio(3);
+
+    // nothing is learned until both wheels have turned enough
+    model.learnRatio(100, 99, 3, 3);
+    TEST_ASSERT_FALSE(model.ratiosChanged());
+    TEST_ASSERT_EQUAL_FLOAT(initial_ratio, model.getRatio(3));
+
+    // at power 100 the right wheel needs 5% more power than the left to keep up, which is learned a bounded step at
+    // a time, only by the entry for power 100
+    for (int i = 0; i < 10; i++) {
+        model.learnRatio(100, 105, 40, 40);
+    }
+    TEST_ASSERT_TRUE(model.ratiosChanged());
+    TEST_ASSERT_TRUE(model.getRatio(3) > initial_ratio);
+    TEST_ASSERT_TRUE(model.getRatio(3) <= initial_ratio + 10*0.01 + 0.0001);
+    TEST_ASSERT_EQUAL_FLOAT(1.00244, model.getRatio(2));
+    TEST_ASSERT_EQUAL_FLOAT(0.98535, model.getRatio(4));
+    for (int i = 0; i < 50; i++) {
+        model.learnRatio(100, 105, 40, 40);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.05, model.getRatio(3));
+
+    // the right power follows the learned ratio straight away
+    model.setAverageSpeed(100);
+    TEST_ASSERT_INT_WITHIN(1, 105, model.getSpeedB());
+    model.setAverageSpeed(105);
+    TEST_ASSERT_INT_WITHIN(1, 105*(1.05 + 0.98535)/2, model.getSpeedB());
+
+    // where the right wheel turned faster at equal power, the ratio drops below 1
+    for (int i = 0; i < 100; i++) {
+        model.learnRatio(100, 100, 40, 42);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 40.0/42.0, model.getRatio(3));
+
+    // the learned table survives a restart
+    const int address = EEPROM_TEST_ADDRESS + 100;
+    model.saveRatios(address);
+    TEST_ASSERT_FALSE(model.ratiosChanged());
+    SpeedModel restarted;
+    TEST_ASSERT_TRUE(restarted.loadRatios(address));
+    TEST_ASSERT_EQUAL_FLOAT(model.getRatio(3), restarted.getRatio(3));
+    TEST_ASSERT_EQUAL_FLOAT(model.getRatio(0), restarted.getRatio(0));
+    TEST_ASSERT_FALSE(restarted.loadRatios(address + 1));
+}
@@ -0,0 +1,7 @@
+#ifndef __TEST_SPEEDMODEL_H__
+#define __TEST_SPEEDMODEL_H__
+
+void test_SpeedModel(void);
+void test_SpeedModel_learning(void);
+
+#endif // __TEST_SPEEDMODEL_H__
@@ -0,0 +1,56 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_TurnModel.h"
+#include "TurnModel.h"
+#include "EEPROMRecord.h"
+
+void test_TurnModel(void) {
+    TurnModel model(80, 140, 2.0, 0.0006, 0.3);
+
+    // the power tapers from full power down to the lowest turning power as the turn nears the cut off
+    TEST_ASSERT_EQUAL_UINT8(140, model.power(90.0));
+    TEST_ASSERT_EQUAL_UINT8(140, model.power(30.0));
+    TEST_ASSERT_EQUAL_UINT8(100, model.power(10.0));
+    TEST_ASSERT_EQUAL_UINT8(80, model.power(0.0));
+    TEST_ASSERT_EQUAL_UINT8(80, model.power(-5.0));
+
+    // at 100 degrees/s the robot coasts 6 degrees, so the power is cut 6 degrees early
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 6.0, model.coastAngle(100.0));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 6.0, model.coastAngle(-100.0));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 4.0, model.cutoffAngle(10.0, 100.0));
+    TEST_ASSERT_TRUE(model.cutoffAngle(5.0, 100.0) < 0.0);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 10.0, model.cutoffAngle(10.0, 0.0));
+}
+
+void test_TurnModel_learning(void) {
+    TurnModel model(80, 140, 2.0, 0.0006, 0.3);
+
+    // a slow turn coasts too little to learn from
+    model.learn(10.0, 2.0);
+    TEST_ASSERT_FALSE(model.changed());
+    TEST_ASSERT_EQUAL_FLOAT(0.0006, model.getCoastFactor());
+
+    // a slippery floor, where the robot coasts 12 degrees from 100 degrees/s, is learned over a few turns
+    model.learn(100.0, 12.0);
+    TEST_ASSERT_TRUE(model.changed());
+    TEST_ASSERT_FLOAT_WITHIN(0.000001, 0.0006 + 0.3*(0.0012 - 0.0006), model.getCoastFactor());
+    for (int i = 0; i < 20; i++) {
+        model.learn(-100.0, 12.0);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 12.0, model.coastAngle(100.0));
+
+    // a turn that went backwards after the cut off does not make the coast factor negative
+    for (int i = 0; i < 20; i++) {
+        model.learn(100.0, -3.0);
+    }
+    TEST_ASSERT_TRUE(model.getCoastFactor() >= 0.0);
+
+    // the learned model survives a restart
+    model.learn(100.0, 8.0);
+    const int address = EEPROM_TEST_ADDRESS + 200;
+    model.save(address);
+    TEST_ASSERT_FALSE(model.changed());
+    TurnModel restarted(80, 140, 2.0, 0.0006, 0.3);
+    TEST_ASSERT_TRUE(restarted.load(address));
+    TEST_ASSERT_EQUAL_FLOAT(model.getCoastFactor(), restarted.getCoastFactor());
+}
@@ -0,0 +1,7 @@
+#ifndef __TEST_TURNMODEL_H__
+#define __TEST_TURNMODEL_H__
+
+void test_TurnModel(void);
+void test_TurnModel_learning(void);
+
+#endif // __TEST_TURNMODEL_H__
@@ -0,0 +1,55 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_WheelEncoder.h"
+#include "WheelEncoder.h"
+
+void test_WheelEncoder(void) {
+    WheelEncoder encoder(10.0);
+
+    // the edges are simulated by calling the interrupt handler with the edge times
+    TEST_ASSERT_EQUAL_UINT32(0, encoder.count());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.speed(0));
+    encoder.record_edge(1000);
+    TEST_ASSERT_EQUAL_UINT32(1, encoder.count());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.speed(1000));
+
+    // steady edges every 10 ms are 10 mm per 10 ms
+    for (uint32_t t = 11000; t <= 71000; t += 10000) {
+        encoder.record_edge(t);
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, encoder.count());
+    TEST_ASSERT_EQUAL_DOUBLE(1000.0, encoder.speed(71000));
+    TEST_ASSERT_EQUAL_DOUBLE(1000.0, encoder.filtered_speed(71000));
+
+    // the instantaneous speed follows a faster edge right away, the filtered speed averages it over the buffer
+    encoder.record_edge(76000);
+    TEST_ASSERT_EQUAL_DOUBLE(2000.0, encoder.speed(76000));
+    TEST_ASSERT_DOUBLE_WITHIN(0.5, 10.0*1000000.0/9286.0, encoder.filtered_speed(76000));
+
+    // without new edges the speed falls as the time since the last edge grows, until the wheel is considered stopped
+    TEST_ASSERT_EQUAL_DOUBLE(500.0, encoder.speed(96000));
+    TEST_ASSERT_EQUAL_DOUBLE(500.0, encoder.filtered_speed(96000));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.speed(76000 + WHEEL_ENCODER_STALL_MICROS + 1));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.filtered_speed(76000 + WHEEL_ENCODER_STALL_MICROS + 1));
+
+    encoder.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, encoder.count());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.speed(76000));
+    encoder.record_edge(80000);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, encoder.speed(80000));
+}
+
+void test_WheelEncoder_wrap(void) {
+    WheelEncoder encoder(5.0);
+
+    // enough edges for the head index to wrap, with the micros() time also wrapping
+    uint32_t t = 0xFFFFFFFFUL - 100000UL;
+    for (int i = 0; i < 300; i++) {
+        encoder.record_edge(t);
+        t += 2500;
+    }
+    t -= 2500;
+    TEST_ASSERT_EQUAL_UINT32(300, encoder.count());
+    TEST_ASSERT_EQUAL_DOUBLE(2000.0, encoder.speed(t));
+    TEST_ASSERT_EQUAL_DOUBLE(2000.0, encoder.filtered_speed(t + 1000));
+}
@@ -0,0 +1,7 @@
+#ifndef __TEST_WHEELENCODER_H__
+#define __TEST_WHEELENCODER_H__
+
+void test_WheelEncoder(void);
+void test_WheelEncoder_wrap(void);
+
+#endif // __TEST_WHEELENCODER_H__
@@ -0,0 +1,39 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_WheelSpeedController.h"
+#include "WheelSpeedController.h"
+
+void test_WheelSpeedController(void) {
+    WheelSpeedController controller(0.1, 0.5, 60);
+    controller.setFeedforward(75, 100, 400.0);
+
+    // the feedforward is a line from the stall power to the reference power
+    TEST_ASSERT_EQUAL_UINT8(0, controller.feedforward(0.0));
+    TEST_ASSERT_EQUAL_UINT8(100, controller.feedforward(400.0));
+    TEST_ASSERT_EQUAL_UINT8(125, controller.feedforward(800.0));
+    TEST_ASSERT_EQUAL_UINT8(255, controller.feedforward(10000.0));
+
+    // the first update only starts the controller's clock, so the power is the feedforward
+    controller.setTargetSpeed(400.0);
+    TEST_ASSERT_EQUAL_UINT8(100, controller.update(0.0, 0));
+
+    // a wheel that is slower than commanded gets more power, and the integral keeps adding power while it stays slow
+    uint8_t power = controller.update(300.0, 10);
+    TEST_ASSERT_EQUAL_UINT8(110, power);
+    TEST_ASSERT_TRUE(controller.update(300.0, 20) > power);
+
+    // a wheel that is faster than commanded gets less power
+    controller.reset();
+    controller.update(400.0, 0);
+    TEST_ASSERT_TRUE(controller.update(500.0, 10) < 100);
+
+    // the correction is limited
+    controller.reset();
+    controller.update(400.0, 0);
+    TEST_ASSERT_EQUAL_UINT8(160, controller.update(-10000.0, 10));
+
+    // a zero speed turns the motor off
+    controller.setTargetSpeed(0.0);
+    TEST_ASSERT_EQUAL_UINT8(0, controller.update(400.0, 20));
+    TEST_ASSERT_EQUAL_UINT8(0, controller.getPower());
+}
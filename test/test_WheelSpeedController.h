@@ -0,0 +1,6 @@
+#ifndef __TEST_WHEELSPEEDCONTROLLER_H__
+#define __TEST_WHEELSPEEDCONTROLLER_H__
+
+void test_WheelSpeedController(void);
+
+#endif // __TEST_WHEELSPEEDCONTROLLER_H__
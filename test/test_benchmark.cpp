@@ -0,0 +1,199 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_benchmark.h"
+#include "DataTable.h"
+#include "Odometry.h"
+#include "PIDController.h"
+#include "SpeedModel.h"
+#include "test_odometry_reference.h"
+
+// Benchmarks report their timings with TEST_MESSAGE rather than asserting on them, since the times depend on the
+// board (or host) the tests run on.
+
+// discards everything written to it, so only the cost of formatting is measured
+class NullStream : public Stream {
+public:
+    size_t count;
+
+    NullStream() : count(0) {}
+
+    virtual int available() override               { return 0; }
+    virtual int read() override                     { return -1; }
+    virtual int peek() override                     { return -1; }
+    virtual size_t write(uint8_t c) override        { count++; return 1; }
+    virtual size_t write(const uint8_t* buffer, size_t size) override {
+        count += size;
+        return size;
+    }
+    using Print::write;
+};
+
+void benchmark_DataTable_csv(void) {
+    const int NUM_COLUMNS = 16;
+    const int NUM_ROWS = 40;
+    const int NUM_DUMPS = 5;
+    String column_names[NUM_COLUMNS];
+    for (int i = 0; i < NUM_COLUMNS; i++) {
+        column_names[i] = String("column ") + String(i);
+    }
+    // typed columns like the move data table's, so the 40 rows take 1.8 KB and fit comfortably into the Mega's heap.
+    // The table is dumped several times to time as many rows as a long move has
+    const DataColumnType column_types[NUM_COLUMNS] = {
+        DATA_COLUMN_UINT32, DATA_COLUMN_UINT16, DATA_COLUMN_UINT16, DATA_COLUMN_UINT8, DATA_COLUMN_UINT8,
+        DATA_COLUMN_UINT8, DATA_COLUMN_UINT8, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32,
+        DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_FLOAT32, DATA_COLUMN_UINT16, DATA_COLUMN_FLOAT32,
+        DATA_COLUMN_FLOAT32
+    };
+    FixedDataTable<double, NUM_COLUMNS> dt(column_names, column_types, NUM_ROWS, DATA_TABLE_FIXED);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        double x = i*0.37;
+        dt.append(i*80, i, i, 1, 1, 100, 110, x, x*i, -x, x*100.0, x/3.0, -x/7.0, 2000, x*0.001, 0.0);
+    }
+    TEST_ASSERT_EQUAL(NUM_ROWS, dt.num_rows());
+
+    // the formatting Robot::move() used before it had DataColumnFormats
+    NullStream before;
+    unsigned long start = micros();
+    for (int i = 0; i < NUM_DUMPS; i++) {
+        dt.write_to_stream(before, [](double value, int col_num) -> String {
+            if (col_num < 7 || col_num == 13) {
+                return String(value, 0);
+            }
+            if (value == 0.0) {
+                return String("0");
+            }
+            return String(value, col_num >= 14 ? 8 : 2);
+        });
+    }
+    unsigned long before_micros = micros() - start;
+
+    const DataColumnFormat formats[NUM_COLUMNS] = {
+        {0, false}, {0, false}, {0, false}, {0, false}, {0, false}, {0, false}, {0, false},
+        {2, true}, {2, true}, {2, true}, {2, true}, {2, true}, {2, true},
+        {0, false}, {8, true}, {8, true}
+    };
+    NullStream after;
+    start = micros();
+    for (int i = 0; i < NUM_DUMPS; i++) {
+        dt.write_to_stream(after, formats);
+    }
+    unsigned long after_micros = micros() - start;
+
+    char message[100];
+    snprintf(
+        message,
+        sizeof(message),
+        "DataTable 200x16 CSV: String formatter %lu us, DataColumnFormat %lu us",
+        before_micros,
+        after_micros
+    );
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(before.count, after.count);
+}
+
+void benchmark_odometry(void) {
+    const int NUM_STEPS = 1000;
+    FixedOdometry odometry(ODOMETRY_WHEEL_CIRCUMFERENCE, ODOMETRY_DISC_HOLE_COUNT, ODOMETRY_WHEEL_BASE);
+
+    // wheel counter deltas like those of a telemetry step, mostly on an arc
+    ReferenceOdometryStep reference_step;
+    double reference_total = 0.0;
+    unsigned long start = micros();
+    for (int i = 0; i < NUM_STEPS; i++) {
+        reference_odometry_step(4 + (i & 3), 5 + ((i >> 2) & 3), reference_step);
+        reference_total += reference_step.forward;
+    }
+    unsigned long reference_micros = micros() - start;
+
+    OdometryStep fixed_step;
+    int64_t fixed_total = 0;
+    start = micros();
+    for (int i = 0; i < NUM_STEPS; i++) {
+        odometry.step(4 + (i & 3), 5 + ((i >> 2) & 3), fixed_step);
+        fixed_total += fixed_step.forward;
+    }
+    unsigned long fixed_micros = micros() - start;
+
+    // report cycles per step, which is what limits the control rate on the AVR. On a host with an FPU the double
+    // version is the faster one
+    char message[120];
+    snprintf(
+        message,
+        sizeof(message),
+        "Odometry 1000 steps: double %lu us (%lu cycles/step), Q16.16 %lu us (%lu cycles/step)",
+        reference_micros,
+        (unsigned long)((uint64_t)reference_micros*(F_CPU/1000000UL)/NUM_STEPS),
+        fixed_micros,
+        (unsigned long)((uint64_t)fixed_micros*(F_CPU/1000000UL)/NUM_STEPS)
+    );
+    TEST_MESSAGE(message);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01*NUM_STEPS, reference_total, fixed_total/65536.0);
+}
+
+void benchmark_PIDController(void) {
+    const int NUM_UPDATES = 1000;
+    PIDController reference(3.0, 0.1, 0.3, -30, 30);
+    FixedPIDController fixed(3.0, 0.1, 0.3, -30, 30);
+    reference.setDerivativeFilter(0.3);
+    fixed.setDerivativeFilter(0.3);
+
+    // the measurements are prepared first, so only the updates are timed
+    double measurements[16];
+    q16_t fixed_measurements[16];
+    for (int i = 0; i < 16; i++) {
+        measurements[i] = 5.0*sin(i*0.4);
+        fixed_measurements[i] = q16_from_double(measurements[i]);
+    }
+
+    double reference_total = 0.0;
+    unsigned long start = micros();
+    for (int i = 0; i < NUM_UPDATES; i++) {
+        reference_total += reference.update(measurements[i & 15], i*10UL);
+    }
+    unsigned long reference_micros = micros() - start;
+
+    int64_t fixed_total = 0;
+    start = micros();
+    for (int i = 0; i < NUM_UPDATES; i++) {
+        fixed_total += fixed.update(fixed_measurements[i & 15], i*10UL);
+    }
+    unsigned long fixed_micros = micros() - start;
+
+    char message[120];
+    snprintf(
+        message,
+        sizeof(message),
+        "PIDController 1000 updates: double %lu us (%lu cycles/update), Q16.16 %lu us (%lu cycles/update)",
+        reference_micros,
+        (unsigned long)((uint64_t)reference_micros*(F_CPU/1000000UL)/NUM_UPDATES),
+        fixed_micros,
+        (unsigned long)((uint64_t)fixed_micros*(F_CPU/1000000UL)/NUM_UPDATES)
+    );
+    TEST_MESSAGE(message);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01*NUM_UPDATES, reference_total, fixed_total/65536.0);
+}
+
+void benchmark_SpeedModel(void) {
+    const int NUM_UPDATES = 1000;
+    SpeedModel model;
+
+    // a speed ramp, as a motion profile sets it on every control tick
+    uint32_t total = 0;
+    unsigned long start = micros();
+    for (int i = 0; i < NUM_UPDATES; i++) {
+        model.setAverageSpeed(i & 0xFF);
+        total += model.getSpeedB();
+    }
+    unsigned long elapsed = micros() - start;
+
+    char message[100];
+    snprintf(
+        message,
+        sizeof(message),
+        "SpeedModel 1000 speed changes: %lu us (%lu cycles/change)",
+        elapsed,
+        (unsigned long)((uint64_t)elapsed*(F_CPU/1000000UL)/NUM_UPDATES)
+    );
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(total > 0);
+}
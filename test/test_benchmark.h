@@ -0,0 +1,9 @@
+#ifndef __TEST_BENCHMARK_H__
+#define __TEST_BENCHMARK_H__
+
+void benchmark_DataTable_csv(void);
+void benchmark_odometry(void);
+void benchmark_PIDController(void);
+void benchmark_SpeedModel(void);
+
+#endif // __TEST_BENCHMARK_H__
@@ -1,7 +1,23 @@
 #include <Arduino.h>
 #include <unity.h>
+#include "test_benchmark.h"
+#include "test_ControlTimer.h"
 #include "test_DataTable.h"
+#include "test_EEPROMRecord.h"
+#include "test_FixedPoint.h"
+#include "test_HeadingFilter.h"
+#include "test_LogEvent.h"
+#include "test_MotionProfile.h"
+#include "test_PIDController.h"
 #include "test_PointSequence.h"
+#include "test_PoseEstimator.h"
+#include "test_PurePursuit.h"
+#include "test_RelayAutotuner.h"
+#include "test_RingBuffer.h"
+#include "test_SpeedModel.h"
+#include "test_TurnModel.h"
+#include "test_WheelEncoder.h"
+#include "test_WheelSpeedController.h"
 
 void setUp (void) {} /* Is run before every test, put unit init calls here. */
 void tearDown (void) {} /* Is run after every test, put unit clean-up calls here. */
@@ -9,14 +25,91 @@ void tearDown (void) {} /* Is run after every test, put unit clean-up calls here
 int runUnityTests(void) {
     UNITY_BEGIN();
 
+    // Control Timer
+    RUN_TEST(test_ControlTimer);
+
     // Data Table
     RUN_TEST(test_DataTable);
     RUN_TEST(test_DataTable_extend);
     RUN_TEST(test_DataTable_custom_formatter);
+    RUN_TEST(test_DataTable_binary);
+    RUN_TEST(test_DataTable_fixed);
+    RUN_TEST(test_DataTable_ring);
+    RUN_TEST(test_DataTable_append);
+    RUN_TEST(test_DataTable_column_types);
+    RUN_TEST(test_DataTable_streaming);
+    RUN_TEST(test_DataTable_formats);
+    RUN_TEST(test_DataTable_binary_compressed);
+    RUN_TEST(test_DataTable_binary_quantized);
+    RUN_TEST(test_DataTable_binary_move_rows);
+
+    // EEPROM Record
+    RUN_TEST(test_EEPROMRecord);
+
+    // Fixed Point
+    RUN_TEST(test_FixedPoint_math);
+    RUN_TEST(test_FixedPoint_sin_cos);
+    RUN_TEST(test_FixedOdometry);
+
+    // Heading Filter
+    RUN_TEST(test_HeadingFilter);
+    RUN_TEST(test_HeadingFilter_drift);
+
+    // Log Events
+    RUN_TEST(test_LogEventRecord);
+    RUN_TEST(test_LogEventRecord_truncated);
+    RUN_TEST(test_LogFrameStream);
+
+    // Motion Profile
+    RUN_TEST(test_MotionProfile);
+    RUN_TEST(test_MotionProfile_short);
+
+    // PID Controller
+    RUN_TEST(test_PIDController);
+    RUN_TEST(test_PIDController_anti_windup);
+    RUN_TEST(test_PIDController_derivative);
+    RUN_TEST(test_PIDController_fixed_point);
 
     // Point Sequence
     RUN_TEST(test_Point_math);
     RUN_TEST(test_PointSequence);
+
+    // Pose Estimator
+    RUN_TEST(test_PoseEstimator);
+    RUN_TEST(test_PoseEstimator_trajectory);
+
+    // Pure Pursuit
+    RUN_TEST(test_PurePursuit);
+    RUN_TEST(test_PurePursuit_path);
+
+    // Relay Autotuner
+    RUN_TEST(test_RelayAutotuner);
+    RUN_TEST(test_RelayAutotuner_timeout);
+
+    // Ring Buffer
+    RUN_TEST(test_RingBuffer);
+    RUN_TEST(test_RingBuffer_wrap);
+
+    // Speed Model
+    RUN_TEST(test_SpeedModel);
+    RUN_TEST(test_SpeedModel_learning);
+
+    // Turn Model
+    RUN_TEST(test_TurnModel);
+    RUN_TEST(test_TurnModel_learning);
+
+    // Wheel Encoder
+    RUN_TEST(test_WheelEncoder);
+    RUN_TEST(test_WheelEncoder_wrap);
+
+    // Wheel Speed Controller
+    RUN_TEST(test_WheelSpeedController);
+
+    // Benchmarks
+    RUN_TEST(benchmark_DataTable_csv);
+    RUN_TEST(benchmark_odometry);
+    RUN_TEST(benchmark_PIDController);
+    RUN_TEST(benchmark_SpeedModel);
     return UNITY_END();
 }
 
@@ -0,0 +1,42 @@
+#ifndef __TEST_ODOMETRY_REFERENCE_H__
+#define __TEST_ODOMETRY_REFERENCE_H__
+#include <Arduino.h>
+
+// The floating point odometry that Robot::move() used before FixedOdometry, which the fixed point version is
+// compared against for accuracy and speed.
+
+#define ODOMETRY_WHEEL_CIRCUMFERENCE 214.0
+#define ODOMETRY_DISC_HOLE_COUNT 20
+#define ODOMETRY_WHEEL_BASE 132.5
+
+typedef struct {
+    double forward;
+    double lateral;
+    double angle;
+    double radius;
+} ReferenceOdometryStep;
+
+inline void reference_odometry_step(uint16_t left_delta, uint16_t right_delta, ReferenceOdometryStep& step) {
+    const double angle_factor = ODOMETRY_WHEEL_CIRCUMFERENCE/ODOMETRY_DISC_HOLE_COUNT/ODOMETRY_WHEEL_BASE;
+    uint16_t outside = right_delta > left_delta ? right_delta : left_delta;
+    uint16_t inside = right_delta > left_delta ? left_delta : right_delta;
+    if (outside == inside) {
+        step.forward = right_delta*ODOMETRY_WHEEL_CIRCUMFERENCE/(double)ODOMETRY_DISC_HOLE_COUNT;
+        step.lateral = 0.0;
+        step.angle = 0.0;
+        step.radius = 0.0;
+        return;
+    }
+    double angle = angle_factor*(outside - inside);
+    step.radius = ODOMETRY_WHEEL_BASE*inside/(outside - inside);
+    step.forward = (step.radius + ODOMETRY_WHEEL_BASE/2)*sin(angle);
+    step.lateral = (step.radius + ODOMETRY_WHEEL_BASE/2)*(1.0 - cos(angle));
+    if (left_delta > right_delta) {
+        step.angle = -angle;
+        step.lateral = -step.lateral;
+    } else {
+        step.angle = angle;
+    }
+}
+
+#endif // __TEST_ODOMETRY_REFERENCE_H__
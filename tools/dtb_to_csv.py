@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""Converts data tables written in the robot's binary table format (see include/DataTable.h) back to CSV.
+
+The input can be a `.dtb` file from the SD card or a raw capture of the serial output, in which the tables are framed
+to keep them apart from the log's event records (see include/LogEvent.h). Every table found in the input is decoded. With a single table the CSV is written to stdout (or the `--output` file), with several tables each one is
+written to its own file named after the input file. Tables with delta and varint compressed rows are decoded losslessly,
+and quantized columns are written with the decimals they were quantized to.
+
+    python3 tools/dtb_to_csv.py log/t012000.dtb > move.csv
+    python3 tools/dtb_to_csv.py serial_capture.bin --output tables.csv
+"""
+import argparse
+import os
+import struct
+import sys
+
+from log_events import extract_framed_data
+
+MAGIC = b"DTB"
+SUPPORTED_VERSIONS = (1,)
+FLAG_DELTA_VARINT = 0x01
+FLAG_QUANTIZED = 0x02
+SUPPORTED_FLAGS = FLAG_DELTA_VARINT | FLAG_QUANTIZED
+NOT_QUANTIZED = 0xFF
+QUANTIZED_INVALID = -0x80000000
+
+# column type code -> (struct format, is float)
+COLUMN_TYPES = {
+    1: ("B", False),
+    2: ("b", False),
+    3: ("H", False),
+    4: ("h", False),
+    5: ("I", False),
+    6: ("i", False),
+    7: ("f", True),
+    8: ("d", True),
+}
+
+
+class TableFormatError(Exception):
+    pass
+
+
+class DataTable:
+    def __init__(self, column_names, column_types, rows, column_decimals=None):
+        self.column_names = column_names
+        self.column_types = column_types
+        self.rows = rows
+        # the decimals each real valued column was quantized to, or None
+        self.column_decimals = column_decimals or [None] * len(column_types)
+
+
+def decode_table(data, offset):
+    """Decodes the table that starts at `offset`. Returns the table and the offset just past its end."""
+    if data[offset:offset + 3] != MAGIC:
+        raise TableFormatError("no table header at offset {}".format(offset))
+    version, flags, num_columns, num_rows = struct.unpack_from("<BBBI", data, offset + 3)
+    if version not in SUPPORTED_VERSIONS:
+        raise TableFormatError("unsupported table format version {}".format(version))
+    if flags & ~SUPPORTED_FLAGS:
+        raise TableFormatError("unsupported table flags 0x{:02x}".format(flags))
+    if flags & FLAG_QUANTIZED and not flags & FLAG_DELTA_VARINT:
+        raise TableFormatError("quantized table without compressed rows")
+    offset += 10
+
+    column_names = []
+    column_types = []
+    column_decimals = []
+    for _ in range(num_columns):
+        type_code, name_length = struct.unpack_from("<BB", data, offset)
+        if type_code not in COLUMN_TYPES:
+            raise TableFormatError("unknown column type {}".format(type_code))
+        offset += 2
+        column_names.append(data[offset:offset + name_length].decode("ascii", errors="replace"))
+        column_types.append(type_code)
+        offset += name_length
+        decimals = None
+        if flags & FLAG_QUANTIZED:
+            decimals = data[offset]
+            offset += 1
+            if decimals == NOT_QUANTIZED or not COLUMN_TYPES[type_code][1]:
+                decimals = None
+        column_decimals.append(decimals)
+
+    if flags & FLAG_DELTA_VARINT:
+        rows, offset = decode_delta_varint_rows(data, offset, column_types, num_rows, column_decimals)
+        return DataTable(column_names, column_types, rows, column_decimals), offset
+
+    row_format = "<" + "".join(COLUMN_TYPES[t][0] for t in column_types)
+    row_size = struct.calcsize(row_format)
+    if offset + row_size * num_rows > len(data):
+        raise TableFormatError("table is truncated, expected {} rows".format(num_rows))
+    rows = [struct.unpack_from(row_format, data, offset + i * row_size) for i in range(num_rows)]
+    return DataTable(column_names, column_types, rows), offset + row_size * num_rows
+
+
+def decode_varint(data, offset):
+    """Decodes a LEB128 varint. Returns the value and the offset just past it."""
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(data):
+            raise TableFormatError("table is truncated in a compressed row")
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, offset
+        shift += 7
+        if shift > 35:
+            raise TableFormatError("varint is too long")
+
+
+def decode_delta_varint_rows(data, offset, column_types, num_rows, column_decimals):
+    """Decodes rows written with DATA_TABLE_FLAG_DELTA_VARINT, and DATA_TABLE_FLAG_QUANTIZED. See include/DataTable.h
+    for the encoding."""
+    previous = [0] * len(column_types)
+    rows = []
+    for _ in range(num_rows):
+        row = []
+        for column, type_code in enumerate(column_types):
+            decimals = column_decimals[column]
+            if decimals is not None:
+                encoded, offset = decode_varint(data, offset)
+                delta = (encoded >> 1) ^ -(encoded & 1)
+                bits = (previous[column] + delta) & 0xFFFFFFFF
+                previous[column] = bits
+                value = bits - (1 << 32) if bits & 0x80000000 else bits
+                row.append(float("nan") if value == QUANTIZED_INVALID else value / 10 ** decimals)
+                continue
+            if type_code == 8:
+                if offset + 8 > len(data):
+                    raise TableFormatError("table is truncated in a compressed row")
+                row.append(struct.unpack_from("<d", data, offset)[0])
+                offset += 8
+                continue
+            encoded, offset = decode_varint(data, offset)
+            if type_code == 7:
+                bits = encoded ^ previous[column]
+            else:
+                delta = (encoded >> 1) ^ -(encoded & 1)
+                bits = (previous[column] + delta) & 0xFFFFFFFF
+            previous[column] = bits
+            # the 32 bits hold the value sign extended, so the low bytes are the value in the column's own type
+            value_format = "<" + COLUMN_TYPES[type_code][0]
+            row.append(struct.unpack_from(value_format, struct.pack("<I", bits))[0])
+        rows.append(tuple(row))
+    return rows, offset
+
+
+def find_tables(data):
+    """Finds and decodes all tables in `data`. A serial capture has the tables in frames, and anything else in it (log
+    text and event records) is skipped."""
+    if not data.startswith(MAGIC):
+        framed = extract_framed_data(data)
+        if framed:
+            tables = []
+            for table_data in framed:
+                tables += scan_tables(table_data)
+            return tables
+    return scan_tables(data)
+
+
+def scan_tables(data):
+    """Finds and decodes all tables in `data`, skipping anything between them."""
+    tables = []
+    offset = data.find(MAGIC)
+    while offset >= 0:
+        try:
+            table, end = decode_table(data, offset)
+            tables.append(table)
+            offset = data.find(MAGIC, end)
+        except (TableFormatError, struct.error) as err:
+            print("skipping data at offset {}: {}".format(offset, err), file=sys.stderr)
+            offset = data.find(MAGIC, offset + 1)
+    return tables
+
+
+def format_value(value, type_code, decimals, quantized_decimals=None):
+    if not COLUMN_TYPES[type_code][1]:
+        return str(value)
+    if decimals is not None:
+        return "{:.{}f}".format(value, decimals)
+    if quantized_decimals is not None:
+        return "{:.{}f}".format(value, quantized_decimals)
+    if type_code == 7:
+        # 7 significant digits is the precision of a 32-bit float
+        return "{:.7g}".format(value)
+    return repr(value)
+
+
+def write_csv(table, out, decimals=None):
+    out.write(",".join(table.column_names) + "\n")
+    for row in table.rows:
+        out.write(",".join(
+            format_value(value, type_code, decimals, quantized_decimals)
+            for value, type_code, quantized_decimals in zip(row, table.column_types, table.column_decimals)
+        ) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert binary robot data tables to CSV.")
+    parser.add_argument("input", help="a .dtb file or a capture of the robot's serial output")
+    parser.add_argument("--output", "-o", help="the CSV file to write. Defaults to stdout.")
+    parser.add_argument("--decimals", "-d", type=int, help="format real valued columns with this many decimals")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    tables = find_tables(data)
+    if not tables:
+        print("no data tables found in {}".format(args.input), file=sys.stderr)
+        return 1
+
+    if len(tables) == 1:
+        if args.output:
+            with open(args.output, "w") as out:
+                write_csv(tables[0], out, args.decimals)
+        else:
+            write_csv(tables[0], sys.stdout, args.decimals)
+        return 0
+
+    base, _ = os.path.splitext(args.output if args.output else args.input)
+    for i, table in enumerate(tables):
+        file_name = "{}_{:03d}.csv".format(base, i)
+        with open(file_name, "w") as out:
+            write_csv(table, out, args.decimals)
+        print("wrote {} rows to {}".format(len(table.rows), file_name), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""Builds the structured log event dictionary and decodes robot logs that contain event records.
+
+The event IDs are defined in include/LogEvent.h, and each `*_EVENT(EVENT_ID, "format", args...)` call site in the
+source supplies the message format. The firmware only logs the ID, a timestamp and the binary arguments (see
+include/LogEvent.h for the record layout). This module is used by setup_build.py to write the dictionary into the build
+directory at build time, and on the command line to turn a log back into text:
+
+    python3 tools/log_events.py dictionary --output log_events.json
+    python3 tools/log_events.py decode log/log_12.txt
+    python3 tools/log_events.py decode serial_capture.bin --dictionary .pio/build/megaatmega2560/log_events.json
+
+When no dictionary file is given, it is built from the source tree this script lives in.
+"""
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+EVENT_MARKER = 0xE5
+EVENT_HEADER_SIZE = 9
+ARG_STRING = 16
+FRAME_MARKER = 0xE6
+
+# argument type code -> struct format, matches DataColumnType in include/DataTable.h
+ARG_TYPES = {
+    1: "B",
+    2: "b",
+    3: "H",
+    4: "h",
+    5: "I",
+    6: "i",
+    7: "f",
+    8: "d",
+}
+
+LEVEL_PREFIXES = {
+    0: "DEBUG: ",
+    1: "INFO: ",
+    2: "WARNING: ",
+    3: "ERROR: ",
+}
+
+EVENT_ID_PATTERN = re.compile(r"\b(EVENT_\w+)\s*=\s*(\d+)")
+EVENT_CALL_PATTERN = re.compile(
+    r"\b(DEBUG|INFO|WARNING|ERROR)_EVENT\s*\(\s*(EVENT_\w+)\s*,\s*((?:\"(?:[^\"\\]|\\.)*\"\s*)+)"
+)
+STRING_LITERAL_PATTERN = re.compile(r"\"((?:[^\"\\]|\\.)*)\"")
+C_ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "\\": "\\", "\"": "\"", "'": "'", "0": "\0"}
+
+
+class EventDictionaryError(Exception):
+    pass
+
+
+def unescape_c_string(literal):
+    return re.sub(r"\\(.)", lambda m: C_ESCAPES.get(m.group(1), m.group(1)), literal)
+
+
+def parse_event_ids(header_path):
+    with open(header_path) as f:
+        return {name: int(value) for name, value in EVENT_ID_PATTERN.findall(f.read())}
+
+
+def build_dictionary(project_dir):
+    """Scans the project source for event call sites and returns a dictionary of event ID -> event description."""
+    event_ids = parse_event_ids(os.path.join(project_dir, "include", "LogEvent.h"))
+    dictionary = {}
+    for source_dir in ("src", "include"):
+        source_dir = os.path.join(project_dir, source_dir)
+        for file_name in sorted(os.listdir(source_dir)):
+            if not file_name.endswith((".cpp", ".h")):
+                continue
+            path = os.path.join(source_dir, file_name)
+            with open(path) as f:
+                source = f.read()
+            for level, name, literals in EVENT_CALL_PATTERN.findall(source):
+                if name not in event_ids:
+                    raise EventDictionaryError("{}: {} is not defined in LogEvent.h".format(file_name, name))
+                event_format = "".join(unescape_c_string(s) for s in STRING_LITERAL_PATTERN.findall(literals))
+                event_id = event_ids[name]
+                existing = dictionary.get(event_id)
+                if existing is not None and existing["format"] != event_format:
+                    raise EventDictionaryError(
+                        "{}: {} is used with different formats in {} and {}".format(
+                            file_name, name, existing["source"], file_name
+                        )
+                    )
+                dictionary[event_id] = {
+                    "name": name,
+                    "level": level,
+                    "format": event_format,
+                    "source": file_name,
+                }
+    return dictionary
+
+
+def write_dictionary(dictionary, path):
+    with open(path, "w") as f:
+        json.dump({str(k): v for k, v in sorted(dictionary.items())}, f, indent=2)
+
+
+def read_dictionary(path):
+    with open(path) as f:
+        return {int(k): v for k, v in json.load(f).items()}
+
+
+def decode_event_args(payload):
+    args = []
+    offset = 0
+    while offset < len(payload):
+        type_code = payload[offset]
+        offset += 1
+        if type_code == ARG_STRING:
+            length = payload[offset]
+            args.append(payload[offset + 1:offset + 1 + length].decode("ascii", errors="replace"))
+            offset += 1 + length
+        elif type_code in ARG_TYPES:
+            arg_format = "<" + ARG_TYPES[type_code]
+            args.append(struct.unpack_from(arg_format, payload, offset)[0])
+            offset += struct.calcsize(arg_format)
+        else:
+            raise ValueError("unknown argument type {}".format(type_code))
+    return args
+
+
+def format_event(dictionary, level, event_id, timestamp, args):
+    event = dictionary.get(event_id)
+    if event is None:
+        text = "unknown event {} with arguments {}".format(event_id, args)
+    else:
+        try:
+            text = event["format"] % tuple(args)
+        except (TypeError, ValueError):
+            # usually a truncated record, which is missing some of its arguments
+            text = "{} (could not format arguments {})".format(event["format"], args)
+    return LEVEL_PREFIXES.get(level, ""), timestamp, text
+
+
+def read_framed_data(data, offset):
+    """Reads the framed binary data that starts at `offset` (see LOG_FRAME_MARKER in include/LogEvent.h). Returns the
+    data and the offset just past its end frame, or past the end of `data` if the capture was cut short."""
+    framed = bytearray()
+    while offset + 2 <= len(data) and data[offset] == FRAME_MARKER:
+        length = data[offset + 1]
+        offset += 2
+        if length == 0:
+            return bytes(framed), offset
+        framed += data[offset:offset + length]
+        offset += length
+    if offset + 2 > len(data):
+        offset = len(data)
+    return bytes(framed), offset
+
+
+def extract_framed_data(data):
+    """Returns the framed binary data in a log or serial capture, such as binary data tables, skipping the text and
+    the event records."""
+    found = []
+    offset = 0
+    while offset < len(data):
+        if data[offset] == FRAME_MARKER:
+            framed, offset = read_framed_data(data, offset)
+            found.append(framed)
+        elif data[offset] == EVENT_MARKER and offset + EVENT_HEADER_SIZE <= len(data):
+            offset += EVENT_HEADER_SIZE + data[offset + EVENT_HEADER_SIZE - 1]
+        else:
+            offset += 1
+    return found
+
+
+def decode_log(data, dictionary, show_timestamps=False):
+    """Yields the lines of a log, with the event records expanded into text. Framed binary data is skipped."""
+    text = bytearray()
+    offset = 0
+    while offset < len(data):
+        if data[offset] == FRAME_MARKER:
+            framed, offset = read_framed_data(data, offset)
+            if text:
+                yield text.decode("ascii", errors="replace").rstrip("\r")
+                text = bytearray()
+            yield "<{} bytes of binary data, see tools/dtb_to_csv.py>".format(len(framed))
+            continue
+        if data[offset] != EVENT_MARKER:
+            if data[offset] == ord("\n"):
+                yield text.decode("ascii", errors="replace").rstrip("\r")
+                text = bytearray()
+            else:
+                text.append(data[offset])
+            offset += 1
+            continue
+        if offset + EVENT_HEADER_SIZE > len(data):
+            break
+        level, event_id, timestamp, payload_length = struct.unpack_from("<BHIB", data, offset + 1)
+        payload = data[offset + EVENT_HEADER_SIZE:offset + EVENT_HEADER_SIZE + payload_length]
+        offset += EVENT_HEADER_SIZE + payload_length
+        try:
+            args = decode_event_args(payload)
+        except (ValueError, IndexError, struct.error) as err:
+            yield "<corrupt event record {}: {}>".format(event_id, err)
+            continue
+        prefix, timestamp, message = format_event(dictionary, level, event_id, timestamp, args)
+        if show_timestamps:
+            yield "[{:>10} ms] {}{}".format(timestamp, prefix, message)
+        else:
+            yield prefix + message
+    if text:
+        yield text.decode("ascii", errors="replace").rstrip("\r")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Robot structured log event tools.")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    dictionary_parser = subparsers.add_parser("dictionary", help="build the event dictionary from the source")
+    dictionary_parser.add_argument("--output", "-o", default="log_events.json")
+
+    decode_parser = subparsers.add_parser("decode", help="expand the event records in a log into text")
+    decode_parser.add_argument("input", help="a log file or serial capture, or - for stdin")
+    decode_parser.add_argument("--dictionary", help="the event dictionary. Built from the source if not given.")
+    decode_parser.add_argument("--timestamps", "-t", action="store_true", help="show the event timestamps")
+
+    args = parser.parse_args()
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+    if args.command == "dictionary":
+        write_dictionary(build_dictionary(project_dir), args.output)
+        return 0
+
+    dictionary = read_dictionary(args.dictionary) if args.dictionary else build_dictionary(project_dir)
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    for line in decode_log(data, dictionary, args.timestamps):
+        print(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Checks that log_events.py and dtb_to_csv.py keep the event records and the framed binary tables of a serial capture
+apart, including when the table's bytes contain the event marker.
+
+    python3 tools/test_serial_capture.py
+"""
+import os
+import struct
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import dtb_to_csv  # noqa: E402
+import log_events  # noqa: E402
+
+DICTIONARY = {
+    7: {"name": "EVENT_ROBOT_MOVE_COMPLETE", "level": "DEBUG", "format": "moved %d", "source": "Robot.cpp"},
+}
+
+
+def event_record(level, event_id, timestamp, value):
+    payload = struct.pack("<Bh", 4, value)
+    return struct.pack("<BBHIB", log_events.EVENT_MARKER, level, event_id, timestamp, len(payload)) + payload
+
+
+def binary_table():
+    """A table with the event marker in its header and rows, as include/DataTable.h writes it."""
+    table = b"DTB" + struct.pack("<BBBI", 1, 0, 2, 3)
+    table += struct.pack("<BB", 1, 1) + b"a" + struct.pack("<BB", 6, 1) + b"b"
+    for a, b in ((0xE5, -1), (0xE6, 0x0E5E5E5), (1, 0x7FE5)):
+        table += struct.pack("<Bi", a, b)
+    return table
+
+
+def framed(data, frame_size=4):
+    """Frames data the way LogFrameStream does, with small frames so the table spans several."""
+    out = bytearray()
+    for i in range(0, len(data), frame_size):
+        chunk = data[i:i + frame_size]
+        out += bytes([log_events.FRAME_MARKER, len(chunk)]) + chunk
+    return bytes(out + bytes([log_events.FRAME_MARKER, 0]))
+
+
+def mixed_capture():
+    return (
+        b"INFO: starting\r\n"
+        + event_record(0, 7, 1000, 5)
+        + framed(binary_table()) + b"\r\n"
+        + event_record(0, 7, 2000, -3)
+        + b"INFO: done\r\n"
+    )
+
+
+class SerialCaptureTest(unittest.TestCase):
+    def test_decode_log_skips_tables(self):
+        lines = list(log_events.decode_log(mixed_capture(), DICTIONARY))
+        self.assertEqual(lines, [
+            "INFO: starting",
+            "DEBUG: moved 5",
+            "<{} bytes of binary data, see tools/dtb_to_csv.py>".format(len(binary_table())),
+            "",
+            "DEBUG: moved -3",
+            "INFO: done",
+        ])
+
+    def test_dtb_to_csv_reads_framed_tables(self):
+        tables = dtb_to_csv.find_tables(mixed_capture())
+        self.assertEqual(len(tables), 1)
+        self.assertEqual(tables[0].column_names, ["a", "b"])
+        self.assertEqual(tables[0].rows, [(0xE5, -1), (0xE6, 0x0E5E5E5), (1, 0x7FE5)])
+
+    def test_dtb_file(self):
+        tables = dtb_to_csv.find_tables(binary_table())
+        self.assertEqual(len(tables), 1)
+        self.assertEqual(len(tables[0].rows), 3)
+
+
+if __name__ == "__main__":
+    unittest.main()